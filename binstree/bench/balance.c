@@ -0,0 +1,236 @@
+/*
+    Misura il tempo di balance() (Day-Stout-Warren) su alberi non bilanciati di grandi dimensioni e lo confronta
+    con quello della precedente implementazione ricorsiva, riportata qui sotto come recursiveBalance.
+
+    Il file include direttamente binstree.c per costruire la catena degenere senza passare da append,
+    che su chiavi ordinate richiederebbe tempo quadratico. Compilazione ed esecuzione, dalla radice della repo:
+
+        gcc -O2 binstree/bench/balance.c pile/src/pile.c code/src/code.c -lm -lpthread -o dswbench
+        ./dswbench [nnodes] [ripetizioni] [nnodes per recursiveBalance]
+
+    Per ogni albero stampa il tempo migliore tra le ripetizioni e la profondità ottenuta, dopo aver
+    verificato che l'albero risultante sia ordinato, con i puntatori al padre corretti e (per balance) bilanciato.
+    recursiveBalance richiede tempo quadratico sulla catena, quindi viene misurata solo su una catena di
+    4000 nodi (modificabile con il terzo argomento); sugli alberi con chiavi casuali non termina.
+
+    Risultati a -O2 su una macchina con un core (tempo migliore su 3 ripetizioni, profondità ottenuta):
+
+                             recursiveBalance           balance
+        catena,  n=2000:     0.28s      (63)            < 0.0001s  (11)
+        catena,  n=4000:     0.91s      (89)            < 0.0001s  (12)
+        catena,  n=8000:     3.79s      (126)           0.0001s    (13)
+        catena,  n=10^6:     -                          0.063s     (20)
+        casuale, n=10^6:     non termina                0.59s      (20)
+
+    recursiveBalance non raggiunge nemmeno il bilanciamento: maxdepth in modalità BINSTREE_PLAIN
+    confronta le chiavi per riconoscere la fine di un livello.
+*/
+
+#include "../src/binstree.c"
+#include <time.h>
+
+// Implementazione di balance precedente all'algoritmo di Day-Stout-Warren, invariata; serve solo come riferimento
+static void recursiveBalance(struct binstree* tree){
+
+    /*
+        Richiesto: struttura dati albero binario non nullo
+        Effetto: modifica l'albero bilanciando ricorsivamente ciascun sottoalbero.
+                    Dato un nodo (u), radice dell'albero e rispettivamento il sottoalbero
+                    sinistro (sx) la cui radice è il figlio sinistro di u e il sottoalbero destro (dx)
+                    la cui radice è il figlio destro di u, questi si considerano bilanciati se la differenza
+                    della profondita tra il sottoalbero sinistro e il sottoalbero destro è compresa tra -1 e +1.
+
+                    -1 <= depth(sx) - depth(dx) <= +1; altrimenti l'albero è sbilanciato.
+        
+        Attenzione: questo metodo fa uso della ricorsione!
+                    Un albero in modalità BINSTREE_AVL è sempre bilanciato e non viene modificato.
+    */
+    
+    struct binstree *subtree_sx, *subtree_dx, *sub2tree_sx, *sub2tree_dx;
+    int balanced_f;
+
+    assert (tree != NULL);
+
+    if (tree->mode == BINSTREE_AVL || tree->radix == NULL) return;
+
+    // Inizializzo i sottoalberi sinistro e destro della radice
+    // Sono necessari ai fini della ricorsione poichè vengono passati come parametri
+    // per le funzioni alberi e non nodi
+    (subtree_sx = newtree())->radix = tree->radix->sx;
+    (subtree_dx = newtree())->radix = tree->radix->dx;
+
+    // Recursion
+    if (subtree_sx->radix != NULL) recursiveBalance(subtree_sx);
+    if (subtree_dx->radix != NULL) recursiveBalance(subtree_dx);
+
+    // La modifica sul bilanciamento ha effetto sui sottoalberi ma il puntatore al figlio
+    // sinistro o destro della radice continua a puntare al valore iniziale
+    // Per questo assegno come nuovi puntatori i valori delle radici del sottoalbero
+    tree->radix->sx = subtree_sx->radix;
+    tree->radix->dx = subtree_dx->radix;
+
+    // Reserve memory (Questi sottoalberi servono per determinare il tipo di rotazione)
+    sub2tree_dx = newtree();
+    sub2tree_sx = newtree();
+    
+    // Il ciclo prosegue finchè i due sottoalberi non hanno un fattore di bilanciamento compreso tra -1 e 1
+    while(abs((balanced_f = maxdepth(subtree_sx) - maxdepth(subtree_dx))) > 1){
+        
+        // Sottoalbero sbilanciato a sinistra
+        if (balanced_f > 1){
+
+            sub2tree_sx->radix = subtree_sx->radix->sx;
+            sub2tree_dx->radix = subtree_sx->radix->dx;
+
+            // Rotazione semplice RR (right-right)
+            if (maxdepth(sub2tree_sx) >= maxdepth(sub2tree_dx)) RRRotation(tree);
+            // Rotazione doppia LR (left-right)
+            else LRRotation(tree);
+
+
+        }
+
+        // Sottoalbero sbilanciato a destra
+        else{
+
+            sub2tree_sx->radix = subtree_dx->radix->sx;
+            sub2tree_dx->radix = subtree_dx->radix->dx;
+
+            // Rotazione semplice LL (left-left)
+            if (maxdepth(sub2tree_sx) <= maxdepth(sub2tree_dx)) LLRotation(tree);
+            // Rotazione doppia RL (right-left)
+            else RLRotation(tree);
+
+        }
+
+        // Stesso principio di prima
+        subtree_sx->radix = tree->radix->sx;
+        subtree_dx->radix = tree->radix->dx;
+
+    }
+
+    // Libero la memoria allocata per le due strutture
+    free(sub2tree_dx);
+    free(sub2tree_sx);
+
+    // Libero la memoria allocata per le due strutture
+    free(subtree_sx);
+    free(subtree_dx);
+
+}
+
+static double now(){
+
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    return t.tv_sec + t.tv_nsec * 1e-9;
+
+}
+
+// Albero in modalità BINSTREE_PLAIN ridotto a una catena di figli destri con chiavi 0, 1, ..., n-1
+static struct binstree* chainTree(unsigned int n){
+
+    struct binstree *tree = newtree();
+    struct node *nodes = allocBlock(tree, n);
+    unsigned int i;
+
+    for (i=0; i<n; i++) nodes[i] = (struct node){
+        .dx=i + 1 < n ? &(nodes[i + 1]) : NULL, .sx=NULL, .parent=i > 0 ? &(nodes[i - 1]) : NULL,
+        .size=n - i, .key=i, .height=n - i, .value=NULL, .aggregate=NULL
+    };
+
+    tree->radix = n > 0 ? nodes : NULL;
+    tree->nnodes = n;
+
+    return tree;
+
+}
+
+// Albero in modalità BINSTREE_PLAIN con n chiavi casuali inserite con append
+static struct binstree* randomTree(unsigned int n){
+
+    struct binstree *tree = newtree();
+    unsigned int i;
+
+    for (i=0; i<n; i++) append(tree, (unsigned int) rand(), NULL);
+
+    return tree;
+
+}
+
+// Verifica ordinamento, puntatori al padre e, se balanced è vero, bilanciamento del sottoalbero;
+// conta i nodi e ne restituisce la profondità
+static int check(struct node *node, struct node *parent, unsigned int *count, int balanced){
+
+    int sx, dx;
+
+    if (node == NULL) return 0;
+
+    assert(node->parent == parent);
+    assert(node->sx == NULL || node->sx->key <= node->key);
+    assert(node->dx == NULL || node->dx->key >= node->key);
+
+    (*count)++;
+
+    sx = check(node->sx, node, count, balanced);
+    dx = check(node->dx, node, count, balanced);
+
+    assert(!balanced || (sx - dx <= 1 && dx - sx <= 1));
+
+    return (sx > dx ? sx : dx) + 1;
+
+}
+
+static void run(const char *name, void (*rebalance)(struct binstree*), struct binstree* (*make)(unsigned int), unsigned int n, unsigned int reps){
+
+    struct binstree *tree;
+    double start, elapsed, best = -1;
+    unsigned int i, count;
+    int depth = 0;
+
+    for (i=0; i<reps; i++){
+
+        tree = make(n);
+
+        start = now();
+        rebalance(tree);
+        elapsed = now() - start;
+
+        if (best < 0 || elapsed < best) best = elapsed;
+
+        count = 0;
+        depth = check(tree->radix, NULL, &count, rebalance == balance);
+
+        assert(count == n);
+
+        destroyTree(tree);
+
+    }
+
+    printf("%-8s n=%-10u %-16s %.4fs  profondità %d\n", name, n, rebalance == balance ? "balance" : "recursiveBalance", best, depth);
+
+}
+
+int main(int argc, char **argv){
+
+    unsigned int n = argc > 1 ? (unsigned int) strtoul(argv[1], NULL, 10) : 1000000;
+    unsigned int reps = argc > 2 ? (unsigned int) strtoul(argv[2], NULL, 10) : 3;
+    unsigned int small = argc > 3 ? (unsigned int) strtoul(argv[3], NULL, 10) : 4000;
+
+    if (reps == 0) reps = 1;
+
+    srand(2);
+
+    run("catena", recursiveBalance, chainTree, small, reps);
+
+    run("catena", balance, chainTree, small, reps);
+
+    run("catena", balance, chainTree, n, reps);
+
+    run("casuale", balance, randomTree, n, reps);
+
+    return 0;
+
+}
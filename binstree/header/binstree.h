@@ -3,12 +3,17 @@
 #ifndef BINSTREE_H
 #define BINSTREE_H
 
+#include <stdint.h>
 
 #define DEPTH_PREORDER_VISIT 0
 #define DEPTH_POSTORDER_VISIT 1
 #define DEPTH_INORDER_VISIT 2
 #define BREADTH_FIRST_VISIT 3
 
+// Modalità dell'albero
+#define BINSTREE_PLAIN 0
+#define BINSTREE_AVL 1
+
 typedef struct node node;
 
 typedef struct binstree binstree;
@@ -23,10 +28,44 @@ typedef struct pair {
 
 typedef struct generator generator;
 
+typedef struct frozentree frozentree;
+
+// Cursore per la visita dell'albero senza allocazioni: va dichiarato dal chiamante (anche sullo stack)
+// e inizializzato con cursorInit. I campi sono riservati alle funzioni cursor*
+typedef struct cursor {
+
+    int visit;
+
+    // Prossimo nodo da restituire (NULL a visita terminata)
+    struct node *node;
+
+    // Radice dell'albero visitato
+    struct node *root;
+
+    // Profondità del nodo corrente (solo BREADTH_FIRST_VISIT)
+    unsigned int depth;
+
+    // Se bounded è vero la visita termina al primo nodo con chiave >= hi (solo DEPTH_INORDER_VISIT)
+    int bounded;
+
+    unsigned int hi;
+
+} *Cursor;
+
 struct binstree* newtree();
 
+struct binstree* newtreeMode(int mode);
+
+struct binstree* newtreeAggregate(int mode, void* (*combine)(void*, void*), void *identity);
+
 void append(struct binstree *tree, unsigned int key, void* value);
 
+struct binstree* treeFromSorted(unsigned int *keys, void **values, unsigned int n);
+
+struct binstree* treeFromSortedParallel(unsigned int *keys, void **values, unsigned int n, unsigned int threads);
+
+struct binstree* treeMerge(struct binstree *a, struct binstree *b);
+
 struct pair* max(struct binstree *tree);
 
 struct pair* min(struct binstree *tree);
@@ -39,6 +78,8 @@ void* search(struct binstree *tree, unsigned int key);
 
 int isin(struct binstree *tree, unsigned int key);
 
+void searchBatch(struct binstree *tree, unsigned int *keys, unsigned int n, void **out);
+
 struct pair* parent(struct binstree *tree, unsigned int key);
 
 void delete(struct binstree *tree, unsigned int key);
@@ -59,6 +100,20 @@ void RRRotation(struct binstree *tree);
 
 void RLRotation(struct binstree *tree);
 
+struct frozentree* freezeTree(struct binstree *tree);
+
+void* frozenSearch(struct frozentree *frozen, unsigned int key);
+
+void frozenSearchBatch(struct frozentree *frozen, unsigned int *keys, unsigned int n, void **out);
+
+void destroyFrozenTree(struct frozentree *frozen);
+
+int saveTree(struct binstree *tree, const char *path, uint64_t (*handle)(void*), int layout);
+
+struct binstree* loadTree(const char *path, int mode, void* (*resolve)(uint64_t), int verify);
+
+struct frozentree* mapTree(const char *path, int verify);
+
 struct generator* depth_inorder_iter(struct binstree *tree);
 
 struct generator* depth_preorder_iter(struct binstree *tree);
@@ -67,12 +122,36 @@ struct generator* depth_postorder_iter(struct binstree *tree);
 
 struct generator* breadth_first_iter(struct binstree *tree);
 
+void cursorInit(struct cursor *cursor, struct binstree *tree, int visit);
+
+int cursorNext(struct cursor *cursor, unsigned int *key, void **value);
+
+void seek(struct cursor *cursor, struct binstree *tree, unsigned int key);
+
+void rangeIter(struct cursor *cursor, struct binstree *tree, unsigned int lo, unsigned int hi);
+
+unsigned int countRange(struct binstree *tree, unsigned int lo, unsigned int hi);
+
+unsigned int rankOf(struct binstree *tree, unsigned int key);
+
+int selectKth(struct binstree *tree, unsigned int k, unsigned int *key, void **value);
+
+void* aggregateRange(struct binstree *tree, unsigned int lo, unsigned int hi);
+
 struct pair* genNext(struct generator *gen);
 
 struct pair* genCurr(struct generator *gen);
 
 void destroyGenerator(struct generator *gen);
 
+void exportParallel(struct binstree *tree, int visit, unsigned int *keys, void **values, struct pair *items, unsigned int threads);
+
+void keysInto(struct binstree *tree, int visit, unsigned int *keys);
+
+void valuesInto(struct binstree *tree, int visit, void **values);
+
+void itemsInto(struct binstree *tree, int visit, struct pair *items);
+
 unsigned int* keys(struct binstree *tree, int visit);
 
 void* values(struct binstree *tree, int visit);
@@ -0,0 +1,50 @@
+#ifndef CBINSTREE_H
+#define CBINSTREE_H
+
+typedef struct cbinstree cbinstree;
+
+typedef struct cnode cnode;
+
+// Cursore per la visita in ordine delle chiavi: va dichiarato dal chiamante (anche sullo stack)
+// e inizializzato con concurrentSeek o concurrentRangeIter. I campi sono riservati alle funzioni concurrent*
+typedef struct ccursor {
+
+    // Prossimo nodo da esaminare (NULL a visita terminata)
+    struct cnode *node;
+
+    // Se bounded è vero la visita termina alla prima chiave >= hi
+    int bounded;
+
+    unsigned int hi;
+
+} *CCursor;
+
+
+struct cbinstree* newConcurrentTree();
+
+void* concurrentAppend(struct cbinstree *tree, unsigned int key, void *value);
+
+void* concurrentSearch(struct cbinstree *tree, unsigned int key);
+
+int concurrentIsin(struct cbinstree *tree, unsigned int key);
+
+void concurrentDelete(struct cbinstree *tree, unsigned int key);
+
+unsigned int concurrentNnodes(struct cbinstree *tree);
+
+int concurrentMin(struct cbinstree *tree, unsigned int *key, void **value);
+
+int concurrentMax(struct cbinstree *tree, unsigned int *key, void **value);
+
+int concurrentPred(struct cbinstree *tree, unsigned int key, unsigned int *pkey, void **pvalue);
+
+void concurrentSeek(struct ccursor *cursor, struct cbinstree *tree, unsigned int key);
+
+void concurrentRangeIter(struct ccursor *cursor, struct cbinstree *tree, unsigned int lo, unsigned int hi);
+
+int concurrentNext(struct ccursor *cursor, unsigned int *key, void **value);
+
+void destroyConcurrentTree(struct cbinstree *tree);
+
+
+#endif
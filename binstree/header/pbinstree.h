@@ -0,0 +1,57 @@
+#ifndef PBINSTREE_H
+#define PBINSTREE_H
+
+// Profondità massima di un albero AVL con 2^32 nodi, e quindi della pila di un cursore
+#define PSTACK_DEPTH 48
+
+typedef struct pbinstree pbinstree;
+
+typedef struct pnode pnode;
+
+typedef struct psnapshot psnapshot;
+
+// Cursore per la visita in ordine di una snapshot: va dichiarato dal chiamante (anche sullo stack)
+// e inizializzato con snapshotSeek o snapshotRangeIter. I campi sono riservati alle funzioni snapshot*
+typedef struct pcursor {
+
+    // Antenati ancora da visitare del prossimo nodo; il prossimo nodo è in cima (depth 0 a visita terminata)
+    struct pnode *stack[PSTACK_DEPTH];
+
+    unsigned int depth;
+
+    // Se bounded è vero la visita termina alla prima chiave >= hi
+    int bounded;
+
+    unsigned int hi;
+
+} *PCursor;
+
+
+struct pbinstree* newPersistentTree();
+
+void persistentAppend(struct pbinstree *tree, unsigned int key, void *value);
+
+void persistentDelete(struct pbinstree *tree, unsigned int key);
+
+unsigned int persistentNnodes(struct pbinstree *tree);
+
+struct psnapshot* snapshot(struct pbinstree *tree);
+
+void* snapshotSearch(struct psnapshot *snap, unsigned int key);
+
+int snapshotIsin(struct psnapshot *snap, unsigned int key);
+
+unsigned int snapshotNnodes(struct psnapshot *snap);
+
+void snapshotSeek(struct pcursor *cursor, struct psnapshot *snap, unsigned int key);
+
+void snapshotRangeIter(struct pcursor *cursor, struct psnapshot *snap, unsigned int lo, unsigned int hi);
+
+int snapshotNext(struct pcursor *cursor, unsigned int *key, void **value);
+
+void destroySnapshot(struct psnapshot *snap);
+
+void destroyPersistentTree(struct pbinstree *tree);
+
+
+#endif
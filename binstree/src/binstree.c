@@ -1,15 +1,45 @@
 
+// posix_madvise e le altre interfacce POSIX usate per i file vanno richieste esplicitamente anche con -std=c11
+#define _POSIX_C_SOURCE 200809L
+
 #include "../../pile/header/pile.h"  // Require use of pile structure (you can find it inside repo)
 #include "../../code/header/code.h"  // Require use of code structure (you can also find it inside this repo)
 #include "../header/binstree.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <math.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #define TRUE 1
 #define FALSE 0
 
+// Numero minimo di nodi di un sottoalbero perchè la sua costruzione venga affidata ad un altro thread
+#define PARALLEL_THRESHOLD 65536
+
+// Numero di ricerche portate avanti insieme da frozenSearchBatch
+#define FROZEN_BATCH 16
+
+// Numero di ricerche portate avanti insieme da searchBatch su chiavi non ordinate
+#define SEARCH_BATCH 16
+
+// Intestazione dei file prodotti da saveTree
+#define TREEFILE_MAGIC "BINSTRE"
+#define TREEFILE_VERSION 1
+
+// Il file contiene anche la copia in layout di Eytzinger (sezione aperta da mapTree)
+#define TREEFILE_LAYOUT 1
+
+// Dimensione della prima slab di nodi e dimensione massima delle successive (raddoppiano ad ogni allocazione)
+#define SLAB_MIN_NODES 64
+#define SLAB_MAX_NODES 4096
+
 
 typedef struct binstree { 
     
@@ -17,6 +47,17 @@ typedef struct binstree {
     struct node *radix; 
     // Contiene il numero di nodi
     unsigned int nnodes;
+    // BINSTREE_PLAIN oppure BINSTREE_AVL
+    int mode;
+    // Blocchi contigui da cui vengono ricavati i nodi; la prima slab dell'elenco è quella in uso
+    struct slab *slabs;
+    // Numero di nodi non ancora utilizzati della slab in uso
+    unsigned int slabfree;
+    // Nodi rimossi, collegati tramite il campo dx e riutilizzati dai successivi inserimenti
+    struct node *freelist;
+    // Operazione associativa ed elemento neutro con cui aggregare i valori (combine NULL se non registrati)
+    void* (*combine)(void*, void*);
+    void *identity;
     
 } *Bstree;
 
@@ -29,18 +70,72 @@ typedef struct node {
     struct node *sx;
     // Puntatore al node padre
     struct node *parent;
+    // Numero di nodi del sottoalbero radicato nel nodo, mantenuto in tutte le modalità
+    unsigned int size;
     // Oggetto incapsulato nel nodo
     struct {
 
         unsigned int key;
 
+        // Altezza del sottoalbero radicato nel nodo (una foglia ha altezza 1), aggiornata solo in modalità BINSTREE_AVL;
+        // occupa lo spazio di allineamento tra chiave e valore senza aumentare la dimensione del nodo
+        int height;
+
         void* value;
 
     };
+    // Aggregato dei valori del sottoalbero in ordine di chiave (solo se l'albero ha registrato combine)
+    void *aggregate;
 
 } *Node;
 
 
+// Blocco contiguo di nodi; i nodi non vengono mai liberati singolarmente ma insieme alla slab da destroyTree
+struct slab {
+
+    struct slab *next;
+
+    unsigned int count;
+
+    struct node nodes[];
+
+};
+
+
+// Argomenti della costruzione parallela di un sottoalbero
+struct buildarg {
+
+    struct binstree *tree;
+
+    struct node *nodes, *parent, *root;
+
+    unsigned int *keys;
+
+    void **values;
+
+    unsigned int lo, hi, threads;
+
+};
+
+// Argomenti dell'esportazione parallela di un sottoalbero nei buffer del chiamante (buffer NULL ignorati)
+struct exportarg {
+
+    struct node *node;
+
+    int visit;
+
+    // Posizione del primo nodo del sottoalbero nei buffer
+    unsigned int base, threads;
+
+    unsigned int *keys;
+
+    void **values;
+
+    struct pair *items;
+
+};
+
+
 typedef struct generator {
 
     int visit;
@@ -58,8 +153,64 @@ typedef struct generator {
 } *Generator;
 
 
+// Copia immutabile dell'albero in layout di Eytzinger: il nodo i ha figli 2i e 2i+1 e la radice è in posizione 1,
+// così che i 16 discendenti di un nodo a quattro livelli di distanza occupino una sola linea di cache
+typedef struct frozentree {
+
+    // Chiavi in ordine di visita in ampiezza; l'array è allineato alla linea di cache e ha dimensione
+    // capacity (potenza di 2 maggiore di n), le posizioni oltre n non vengono mai confrontate
+    uint32_t *keys;
+
+    void **values;
+
+    unsigned int n, capacity;
+
+    // Mappatura del file da cui provengono chiavi e valori (NULL se la copia è stata creata da freezeTree)
+    void *map;
+
+    unsigned long maplength;
+
+} *FrozenTree;
+
+/*
+    Formato dei file prodotti da saveTree; contiene solo dati relativi e nessun puntatore:
+
+        struct treefile                         intestazione (64 byte)
+        keys[keybytes]                          chiavi in ordine crescente, ciascuna come differenza dalla
+                                                precedente codificata in varint (7 bit per byte, bit alto di continuazione)
+        uint64_t handles[count]                 valori, convertiti in handle dal chiamante, nello stesso ordine
+        (solo con TREEFILE_LAYOUT, dall'offset layout multiplo di 64)
+        uint32_t ekeys[capacity]                chiavi in layout di Eytzinger, come in struct frozentree
+        uint64_t ehandles[count + 1]            handle nello stesso layout
+
+    Ogni sezione è allineata a 8 byte; il formato usa l'ordine dei byte nativo.
+*/
+struct treefile {
+
+    char magic[8];
+
+    uint32_t version;
+
+    uint32_t flags;
+
+    uint64_t count;
+
+    uint64_t keybytes;
+
+    // Dimensione dell'array ekeys e offset della sua sezione (0 senza TREEFILE_LAYOUT)
+    uint64_t capacity, layout;
+
+    // Lunghezza totale del file
+    uint64_t length;
+
+    // Checksum di tutto il contenuto che segue l'intestazione
+    uint64_t checksum;
+
+};
+
+
 // Define static safe malloc that prevents from memory allocations error
-static void* smalloc(unsigned int size){
+static void* smalloc(size_t size){
 
     void* object = malloc(size);
 
@@ -75,757 +226,2025 @@ static void* smalloc(unsigned int size){
 
 }
 
-struct binstree* newtree(){
+// Altezza di un sottoalbero (0 se vuoto)
+static inline int height(struct node *node){
 
-    // Alloco spazio per la struttura dati albero
-    struct binstree *tree = (struct binstree*) smalloc(sizeof(struct binstree));
+    return node != NULL ? node->height : 0;
 
-    tree->radix=NULL;
-    // Restituisce il puntatore all'albero
-    return tree;
+}
+
+// Numero di nodi di un sottoalbero (0 se vuoto)
+static inline unsigned int subtreeSize(struct node *node){
+
+    return node != NULL ? node->size : 0;
 
 }
 
-unsigned int nnodes(struct binstree *tree){
+// Aggregato di un sottoalbero (l'elemento neutro se vuoto)
+static inline void* aggregateOf(struct binstree *tree, struct node *node){
 
-    assert(tree != NULL);
+    return node != NULL ? node->aggregate : tree->identity;
 
-    return tree->nnodes;
+}
+
+// Ricalcola l'aggregato del nodo come combine(combine(sx, valore), dx), rispettando l'ordine delle chiavi
+static inline void updateAggregate(struct binstree *tree, struct node *node){
+
+    node->aggregate = tree->combine(tree->combine(aggregateOf(tree, node->sx), node->value), aggregateOf(tree, node->dx));
 
 }
 
-void append(struct binstree *tree, unsigned int key, void* value){
-    
-    // Verifica che l'oggetto e la funzione non siano nulli
-    assert(tree != NULL);
+// Ricalcola altezza, dimensione e aggregato del nodo a partire da quelli dei figli
+static inline void updateNode(struct binstree *tree, struct node *node){
 
-    struct node *ptr, *parent, **ptrn=&(tree->radix), *newnode;
+    int hsx = height(node->sx), hdx = height(node->dx);
 
-    // Il ciclo prosegue fino a che non raggiunge una foglia dell'albero ossia quando ottiene un puntatore NULL
-    while ((ptr = *ptrn) != NULL){
+    node->height = (hsx > hdx ? hsx : hdx) + 1;
+    node->size = subtreeSize(node->sx) + subtreeSize(node->dx) + 1;
 
-        // Alla fine del ciclo, ptr sarà il puntatore alla foglia e sarà quindi NULL, parent invece
-        // sarà il valore del padre
-        parent = ptr;
-        // Se la chiave del nodo corrente è maggiore della chiave passata come parametro
-        if (ptr->key > key) ptrn = &(ptr->sx);
-        // Se la chiave del nodo corrente è minore o uguale della chiave passata come parametro
-        else if (ptr->key <= key) ptrn = &(ptr->dx);
+    if (tree->combine != NULL) updateAggregate(tree, node);
 
-    }
+}
 
-    *(newnode = smalloc(sizeof(struct node))) = (struct node) {
-        .dx=NULL, .sx=NULL, .parent=parent, 
-        .key=key, .value=value
-    };
+// Ricalcola gli aggregati dal nodo fino alla radice, dopo che il suo sottoalbero è stato modificato
+static void refreshPath(struct binstree *tree, struct node *node){
 
-    *ptrn = newnode;
+    if (tree->combine == NULL) return;
 
-    tree->nnodes++;
+    for (; node != NULL; node = node->parent) updateAggregate(tree, node);
 
 }
 
-// Restituisce il sottoalbero la cui radice corrisponde al valore passato come parametro
-struct binstree* subtree(struct binstree *tree, unsigned int key){
-    
-    struct node *ptop = tree->radix;
-    struct binstree *subtree;
+// Restituisce il puntatore al campo che punta al nodo (figlio del padre oppure radice dell'albero)
+static struct node** linkOf(struct binstree *tree, struct node *node){
 
-    // Verifica che l'oggetto da cercare non sia nullo
-    assert(tree != NULL);
+    struct node *parent;
+
+    if ((parent = node->parent) == NULL) return &(tree->radix);
 
-    while (ptop != NULL){
+    return parent->sx == node ? &(parent->sx) : &(parent->dx);
 
-        // Se il valore di result è 0, restituisce il nodo cercato
-        if (ptop->key == key){
+}
 
-            // Assegna come radice del sottoalbero il nodo il cui valore è item
-            (subtree = newtree())->radix = ptop;
-            // Restituisce il sottoalbero creato
-            return subtree;
+// Ruota a destra il nodo puntato da link con il suo figlio sinistro, aggiornando padri e altezze
+static void rotateRight(struct binstree *tree, struct node **link){
 
-        }  
+    struct node *top = *link, *lchild = top->sx;
 
-        // Se il valore di result è 1, prosegue verso il figlio sinistro
-        else if (ptop->key > key) ptop = ptop->sx;
+    if ((top->sx = lchild->dx) != NULL) top->sx->parent = top;
 
-        // Se il valore di result è -1, prosegue verso il figlio destro
-        else if (ptop->key < key) ptop = ptop->dx;
+    lchild->dx = top;
+    lchild->parent = top->parent;
+    top->parent = lchild;
 
-    }
+    *link = lchild;
 
-    return NULL;
+    updateNode(tree, top);
+    updateNode(tree, lchild);
 
 }
 
-void* search(struct binstree* tree, unsigned int key){
+// Ruota a sinistra il nodo puntato da link con il suo figlio destro, aggiornando padri e altezze
+static void rotateLeft(struct binstree *tree, struct node **link){
 
-    struct node *n;
-    struct binstree *sbt;
+    struct node *top = *link, *rchild = top->dx;
 
-    assert(tree != NULL);
-    // Se il sottoalbero è NULL, allora significa che la chiave non appartiene all'albero
-    if ((sbt = subtree(tree, key)) != NULL && (n = sbt->radix) != NULL) {
-        // Estrae il valore contenuto nella coppia del nodo
-        void* value = n->value;
-        // Dealloco lo spazio riservato per il sottoalbero generato dalla funzione subtree
-        free(sbt);
-        // Resituisce il valore
-        return value;
+    if ((top->dx = rchild->sx) != NULL) top->dx->parent = top;
 
-    }
+    rchild->sx = top;
+    rchild->parent = top->parent;
+    top->parent = rchild;
 
-    return NULL;
+    *link = rchild;
+
+    updateNode(tree, top);
+    updateNode(tree, rchild);
 
 }
 
-int isin(struct binstree *tree, unsigned int key){
+// Ripristina la proprietà AVL nel nodo con al più due rotazioni e restituisce la nuova radice del sottoalbero
+static struct node* rebalance(struct binstree *tree, struct node *node){
 
-    struct binstree *sbt;
+    struct node **link = linkOf(tree, node);
+    int factor = height(node->sx) - height(node->dx);
 
-    assert(tree != NULL);
+    if (factor > 1){
 
-    // Se il sottoalbero è NULL, allora significa che la chiave non appartiene all'albero
-    if ((sbt = subtree(tree, key)) != NULL) {
+        // Caso sinistro-destro: il figlio sinistro pende a destra e va prima ruotato a sinistra
+        if (height(node->sx->sx) < height(node->sx->dx)) rotateLeft(tree, &(node->sx));
 
-        // Dealloco lo spazio riservato per il sottoalbero generato dalla funzione subtree
-        free(sbt);
-        // Resituisce il valore
-        return TRUE;
+        rotateRight(tree, link);
 
     }
-    
-}
 
-void delete(struct binstree *tree, unsigned int key){
+    else if (factor < -1){
 
-    struct binstree *sbttree;
-    struct node *node, *child, *parent;
+        if (height(node->dx->dx) < height(node->dx->sx)) rotateRight(tree, &(node->dx));
 
-    assert(tree != NULL);
+        rotateLeft(tree, link);
 
-    // Se sbttree è NULL significa che il nodo cercato non appartiene all'albero originario
-    if ((sbttree = subtree(tree, key)) != NULL) {
+    }
 
-        // Verifica se figlio sinistro e destro sono nulli (in questo caso il nodo cercato corrisponde ad una foglia)
-        if ((node=sbttree->radix)->sx == NULL && node->dx == NULL) {
+    else updateNode(tree, node);
 
-            if ((parent = node->parent)->key > node->key) parent->sx = NULL;
-            
-            else parent->dx = NULL;
+    return *link;
 
-            free(node);
-        
-        }
+}
 
-        // Se il nodo ha un solo figlio
-        else if ((child=node->sx) != NULL && node->dx == NULL || (child=node->dx) != NULL && node->sx == NULL) {
+// Risale dal nodo verso la radice dopo un inserimento o una rimozione nel suo sottoalbero.
+// Si ferma non appena l'altezza di un sottoalbero resta invariata: gli antenati non ne sono influenzati
+static void retrace(struct binstree *tree, struct node *node){
 
-            // Se il nodo cercato è la radice dell'albero allora il figlio non nullo diventa la radice dell'albero
-            if ((parent = node->parent) == NULL) 
-                // Assegna come radice dell'albero il figlio non nullo del nodo trovato
-                tree->radix = child;
+    int previous;
 
-            // Altrimenti l'arco padre-radice diventa arco padre-figlio non nullo della radice
-            // Presta sempre attenzione al fatto che la radice in questo caso corrisponde alla radice del sottoalbero e quindi è il nodo cercato
-            else {
-            
-                // Se il padre è maggiore della radice allora l'arco diventa figlio sinistro del padre-figlio non nullo della radice
-                if (parent->key > node->key) parent->sx = child;
-            
-                // Altrimenti l'arco diventa figlio destro del padre - figlio non nullo della radice
-                else parent->dx = child;
+    while (node != NULL){
 
-            }
+        previous = node->height;
 
-            free(node);
+        if ((node = rebalance(tree, node))->height == previous) break;
 
-        }
+        node = node->parent;
 
-        else {
+    }
 
-            // Individuo il predecessore del nodo cercato che in questo caso sarà il massimo del sottoalbero sinistro 
-            // Nota che essendo il massimo non può avere 2 figli altrimenti non sarebbe il massimo
-            struct pair* predec = pred(tree, node->key);
+}
 
-            if (predec != NULL) delete(tree, predec->key);
+// Restituisce un nodo libero, preso dalla lista dei nodi rimossi oppure dalla slab in uso
+static struct node* allocNode(struct binstree *tree){
 
-            node->key=predec->key;
-            node->value=predec->value;
+    struct node *newnode;
+    struct slab *slab;
+    unsigned int count;
 
-            free(predec);
+    if ((newnode = tree->freelist) != NULL){
 
-        }
+        tree->freelist = newnode->dx;
 
-        // Dealloca lo spazio per la struttura del sottoalbero generata per la ricerca
-        free(sbttree);
-        // Diminuisce di uno il n. di nodi dell'albero
-        tree->nnodes--;
+        return newnode;
 
     }
 
-}
+    if (tree->slabfree == 0){
 
-struct pair* pred(struct binstree* tree, unsigned int key){
+        count = tree->slabs == NULL ? SLAB_MIN_NODES :
+                    tree->slabs->count < SLAB_MAX_NODES ? tree->slabs->count * 2 : SLAB_MAX_NODES;
 
-    struct binstree *subt, *temp;
-    struct node *parent, *ptru;
-    struct pair *ppred;
+        slab = smalloc(sizeof(struct slab) + count * sizeof(struct node));
+        slab->next = tree->slabs;
+        slab->count = count;
 
-    assert(tree != NULL);
+        tree->slabs = slab;
+        tree->slabfree = count;
 
-    if ((subt = subtree(tree, key)) != NULL) {
+    }
 
-        if ((ptru = subt->radix)->sx == NULL){
+    return &(tree->slabs->nodes[tree->slabs->count - tree->slabfree--]);
 
-            while((parent = ptru->parent) != NULL && ptru->key < key) 
-            
-                ptru = parent;
-            
-            ppred = smalloc(sizeof(struct pair));
-            ppred->key=parent->key;
-            ppred->value=parent->value;
+}
 
-        }
+static void freeNode(struct binstree *tree, struct node *node){
 
-        else {
+    node->dx = tree->freelist;
 
-            (temp = newtree())->radix = ptru->sx;
+    tree->freelist = node;
 
-            ppred = max(temp);
+}
 
-            free(temp);
+// Alloca una slab di count nodi destinata ad essere usata per intero (treeFromSorted, treeMerge).
+// Viene inserita dopo la slab in uso, così che allocNode continui a ricavare nodi da quest'ultima
+static struct node* allocBlock(struct binstree *tree, unsigned int count){
 
-        }
+    struct slab *slab;
+    size_t size = (size_t) count * sizeof(struct node);
 
-        free(subt);
+    // Un blocco la cui dimensione non è rappresentabile in size_t non può essere allocato
+    if (size / sizeof(struct node) != count || size > SIZE_MAX - sizeof(struct slab)){
 
-        return ppred;
+        fprintf(stderr, "Memory allocation error\n");
+
+        exit(0);
 
     }
 
-}
+    slab = smalloc(sizeof(struct slab) + size);
 
-struct pair* parent(struct binstree* tree, unsigned int key){
+    slab->count = count;
 
-    /*  
-        Richiede: struttura dati albero binario non nulla, chiave di ricerca (unsigned int)
-        Effetto: Restituisce il padre del nodo a cui è associata la chiave passata come parametro;
-                    se la chiave non esiste restituisce NULL.
-    */
-    
-    struct pair *pair;
-    struct node *n;
-    struct binstree* sbt;
+    if (tree->slabs == NULL){
 
-    assert(tree != NULL);
+        slab->next = NULL;
 
-    // In questo caso subtree funziona come una search, restituisce però il sottoalbero
-    // alla cui radice appartiene la chiave passata come parametro della funzione.
-    // Nota che se subtree è nullo, significa che la chiave non esiste.
-    if ((sbt = subtree(tree, key)) != NULL) {
+        tree->slabs = slab;
+        tree->slabfree = 0;
 
-        *(pair = smalloc(sizeof(struct pair))) = (struct pair){
-            .key=sbt->radix->key,
-            .value=sbt->radix->value
-        };
+    }
 
-        // Dealloco lo spazio del sottoalbero generato dalla funzione subtree
-        free(sbt);
+    else {
 
-        // Restituisce la coppia chiave-valore del nodo padre
-        return pair;
+        slab->next = tree->slabs->next;
+
+        tree->slabs->next = slab;
 
     }
 
-    return NULL;
+    return slab->nodes;
 
 }
 
-struct pair* max(struct binstree *tree){
+// Collega i nodi nodes[lo, hi) in un albero perfettamente bilanciato prendendo come radice l'elemento centrale
+// e ne restituisce la radice; se keys non è NULL copia nei nodi anche le chiavi e i valori corrispondenti.
+// L'ordine dei nodi nell'array coincide con la visita in ordine
+static struct node* build(struct binstree *tree, struct node *nodes, unsigned int *keys, void **values, unsigned int lo, unsigned int hi, struct node *parent){
 
-    /* 
-        Richiesto: struttura dati albero binario non nulla
-        Effetto: Restituisce la struttura coppia chiave-valore i cui valori corrispondono alla 
-                    massima chiave contenuta nell'albero e il relativo valore.
-                    Nota che la chiave massima dell'albero è per definizione di 
-                    albero binario di ricerca, il nodo destro più profondo del sottoalbero destro.
-    */
-    
-    // ptru contiene l'indirizzo in memoria del PUNTATORE alla radice dell'albero
-    struct node *ptru;
-    struct pair *p;
+    struct node *node;
+    unsigned int mid;
 
-    assert(tree != NULL);
+    if (lo >= hi) return NULL;
 
-    if((ptru = tree->radix) != NULL){
-    
-        // Finchè non raggiunge la profondità massima del sottoalbero sinistro continua
-        while (ptru->dx != NULL) ptru = ptru->dx;
+    node = &(nodes[(mid = lo + (hi - lo) / 2)]);
 
-        // Crea la struttura dati contenente la coppia chiave-valore
-        *(p = smalloc(sizeof(struct pair))) = (struct pair){
-            .key=ptru->key,
-            .value=ptru->value
-        };
+    if (keys != NULL){
 
-        return p;
+        node->key = keys[mid];
+        node->value = values != NULL ? values[mid] : NULL;
 
     }
 
-    return NULL;
+    node->parent = parent;
+    node->sx = build(tree, nodes, keys, values, lo, mid, node);
+    node->dx = build(tree, nodes, keys, values, mid + 1, hi, node);
 
-}
+    updateNode(tree, node);
 
-struct pair* min(struct binstree *tree){
+    return node;
 
-    /* 
-        Richiesto: struttura dati albero binario non nulla
-        Effetto: Restituisce la struttura coppia chiave-valore i cui valori corrispondono alla 
-                    minima chiave contenuta nell'albero e il relativo valore.
-                    Nota che la chiave minima dell'albero è per definizione di 
-                    albero binario di ricerca, il nodo sinistro più profondo del sottoalbero sinistro.
-    */
+}
 
-    // node_pointer contiene l'indirizzo in memoria del PUNTATORE alla radice dell'albero
-    struct node *ptru;
-    struct pair *p;
+static void* buildWorker(void *arg);
 
-    assert(tree != NULL);
+// Come build, ma finchè ha thread a disposizione e il sottoalbero è abbastanza grande costruisce
+// il sottoalbero sinistro in un nuovo thread mentre il thread corrente costruisce quello destro
+static struct node* buildParallel(struct binstree *tree, struct node *nodes, unsigned int *keys, void **values, unsigned int lo, unsigned int hi, struct node *parent, unsigned int threads){
 
-    if ((ptru = tree->radix) != NULL){
+    struct buildarg left;
+    struct node *node;
+    pthread_t thread;
+    unsigned int mid;
+    int spawned;
 
-        // Finchè non raggiunge la profondità massima del sottoalbero sinistro continua
-        while (ptru->sx != NULL) ptru = ptru->sx;
+    if (threads < 2 || hi - lo < PARALLEL_THRESHOLD) return build(tree, nodes, keys, values, lo, hi, parent);
 
-        // Crea la struttura dati contenente la coppia chiave-valore
-        *(p = smalloc(sizeof(struct pair))) = (struct pair){
-            .key=ptru->key,
-            .value=ptru->value
-        };
+    node = &(nodes[(mid = lo + (hi - lo) / 2)]);
 
-        return p;
+    if (keys != NULL){
+
+        node->key = keys[mid];
+        node->value = values != NULL ? values[mid] : NULL;
 
     }
 
-    return NULL;
+    node->parent = parent;
 
-}
+    left = (struct buildarg) {
+        .tree=tree, .nodes=nodes, .parent=node, .keys=keys, .values=values,
+        .lo=lo, .hi=mid, .threads=threads / 2
+    };
 
-void destroyTree(struct binstree *tree){
+    // Se la creazione del thread fallisce il sottoalbero sinistro viene costruito dal thread corrente
+    if ((spawned = pthread_create(&thread, NULL, buildWorker, &left) == 0) == FALSE) buildWorker(&left);
 
-    /* 
-        Richiede: struttura dati albero binario non nulla
-        Effetto: dealloca lo spazio riservato a ciascun nodo dell'albero
-                    e alla struttura dati stessa.
+    node->dx = buildParallel(tree, nodes, keys, values, mid + 1, hi, node, threads - threads / 2);
 
-        Attenzione: non dealloca lo spazio riservato al valore contenuto in ciascun nodo!
-    */
-    
-    struct node *temp;
-    struct pile *pile;
-    
-    // Verifica che la struttura dati passata non sia nulla
-    assert(tree != NULL);
+    if (spawned) pthread_join(thread, NULL);
 
-    // Inizializza la pila e inserisce la radice dell'albero
-    push((pile = newpile()), tree->radix);
+    node->sx = left.root;
 
-    // Continua finchè la pila non è vuota
-    while(!isPileEmpty(pile)){
+    updateNode(tree, node);
 
-        // Se l'elemento estratto non è nullo
-        if ((temp = pop(pile)) != NULL){
+    return node;
 
-            // Inserisco il figlio destro
-            push(pile, temp->dx);
-            // Inserisco il figlio sinistro
-            push(pile, temp->sx);
-            // Ricorda che l'ultimo elemento inserito è il primo ad essere estratto!            
-            free(temp);
+}
 
-        }
+static void* buildWorker(void *arg){
 
-    }
+    struct buildarg *args = arg;
 
-    // Libera lo spazio di memoria allocato per la pila di scorrimento
-    destroyPile(pile);
+    args->root = buildParallel(args->tree, args->nodes, args->keys, args->values, args->lo, args->hi, args->parent, args->threads);
 
-    // Libera lo spazio di memoria allocato per la struttura albero
-    free(tree);
+    return NULL;
+
+}
+
+// Nodo con la chiave minima del sottoalbero
+static struct node* leftmost(struct node *node){
+
+    if (node != NULL) while (node->sx != NULL) node = node->sx;
+
+    return node;
+
+}
+
+// Nodo successivo nella visita in ordine, ottenuto tramite i puntatori al padre senza risalire oltre root
+// (NULL se la visita riguarda l'intero albero)
+static struct node* successor(struct node *node, struct node *root){
+
+    if (node->dx != NULL) return leftmost(node->dx);
+
+    while (node != root && node->parent != NULL && node->parent->dx == node) node = node->parent;
+
+    return node != root ? node->parent : NULL;
+
+}
+
+// Primo nodo con la chiave incontrato scendendo dal nodo, NULL se la chiave non appartiene al sottoalbero
+static inline struct node* findNode(struct node *node, unsigned int key){
+
+    while (node != NULL && node->key != key) node = node->key > key ? node->sx : node->dx;
+
+    return node;
+
+}
+
+struct binstree* newtreeAggregate(int mode, void* (*combine)(void*, void*), void *identity){
+
+    /*
+        Richiede: modalità BINSTREE_PLAIN oppure BINSTREE_AVL, funzione combine associativa
+                    con elemento neutro identity, oppure combine NULL
+        Effetto: crea un albero vuoto come newtreeMode che mantiene in ogni nodo l'aggregato, calcolato con
+                    combine, dei valori del suo sottoalbero nell'ordine delle chiavi (combine non deve essere
+                    commutativa). aggregateRange restituisce l'aggregato di un intervallo di chiavi in tempo
+                    O(maxdepth(tree)), e.g. somma, minimo o massimo dei valori di una finestra temporale.
+                    Ogni modifica dell'albero ricalcola gli aggregati lungo il cammino fino alla radice.
+    */
+
+    struct binstree *tree = newtreeMode(mode);
+
+    tree->combine = combine;
+    tree->identity = identity;
+
+    return tree;
+
+}
+
+struct binstree* newtreeMode(int mode){
+
+    /*
+        Richiede: modalità BINSTREE_PLAIN oppure BINSTREE_AVL
+        Effetto: crea un albero vuoto.
+                    BINSTREE_PLAIN è il classico albero binario di ricerca non bilanciato;
+                    BINSTREE_AVL mantiene, con rotazioni locali durante append e delete, la differenza di altezza
+                    tra i due sottoalberi di ogni nodo compresa tra -1 e +1, così che l'altezza resti O(log n)
+                    anche quando le chiavi vengono inserite in ordine.
+    */
+
+    struct binstree *tree;
+
+    assert(mode == BINSTREE_PLAIN || mode == BINSTREE_AVL);
+
+    // Alloco spazio per la struttura dati albero
+    tree = (struct binstree*) smalloc(sizeof(struct binstree));
+
+    tree->radix=NULL;
+    tree->nnodes=0;
+    tree->mode=mode;
+    tree->slabs=NULL;
+    tree->slabfree=0;
+    tree->freelist=NULL;
+    tree->combine=NULL;
+    tree->identity=NULL;
+    // Restituisce il puntatore all'albero
+    return tree;
+
+}
+
+struct binstree* newtree(){
+
+    return newtreeMode(BINSTREE_PLAIN);
+
+}
+
+unsigned int nnodes(struct binstree *tree){
+
+    assert(tree != NULL);
+
+    return tree->nnodes;
+
+}
+
+void append(struct binstree *tree, unsigned int key, void* value){
+    
+    // Verifica che l'oggetto e la funzione non siano nulli
+    assert(tree != NULL);
+
+    struct node *ptr, *parent=NULL, **ptrn=&(tree->radix), *newnode;
+
+    // Il ciclo prosegue fino a che non raggiunge una foglia dell'albero ossia quando ottiene un puntatore NULL
+    while ((ptr = *ptrn) != NULL){
+
+        // Alla fine del ciclo, ptr sarà il puntatore alla foglia e sarà quindi NULL, parent invece
+        // sarà il valore del padre
+        parent = ptr;
+        // Il nuovo nodo entrerà nel sottoalbero del nodo corrente
+        ptr->size++;
+        // Se la chiave del nodo corrente è maggiore della chiave passata come parametro
+        if (ptr->key > key) ptrn = &(ptr->sx);
+        // Se la chiave del nodo corrente è minore o uguale della chiave passata come parametro
+        else if (ptr->key <= key) ptrn = &(ptr->dx);
+
+    }
+
+    *(newnode = allocNode(tree)) = (struct node) {
+        .dx=NULL, .sx=NULL, .parent=parent, .size=1,
+        .key=key, .height=1, .value=value
+    };
+
+    *ptrn = newnode;
+
+    tree->nnodes++;
+
+    if (tree->mode == BINSTREE_AVL) retrace(tree, parent);
+
+    refreshPath(tree, newnode);
+
+}
+
+struct binstree* treeFromSortedParallel(unsigned int *keys, void **values, unsigned int n, unsigned int threads){
+
+    /*
+        Richiede: array keys di n chiavi ordinate in modo non decrescente, array values di n valori
+                    oppure NULL (tutti i valori saranno NULL), threads >= 1
+        Effetto: restituisce un nuovo albero in modalità BINSTREE_AVL perfettamente bilanciato con le
+                    coppie chiave-valore passate, in tempo O(n) e con un'unica allocazione per tutti i nodi.
+                    I sottoalberi con almeno PARALLEL_THRESHOLD nodi vengono costruiti in parallelo
+                    usando al più threads thread.
+    */
+
+    struct binstree *tree;
+
+    assert(n == 0 || keys != NULL);
+    assert(threads >= 1);
+
+    tree = newtreeMode(BINSTREE_AVL);
+
+    if (n == 0) return tree;
+
+    tree->radix = buildParallel(tree, allocBlock(tree, n), keys, values, 0, n, NULL, threads);
+    tree->nnodes = n;
+
+    return tree;
+
+}
+
+struct binstree* treeFromSorted(unsigned int *keys, void **values, unsigned int n){
+
+    return treeFromSortedParallel(keys, values, n, 1);
+
+}
+
+struct binstree* treeMerge(struct binstree *a, struct binstree *b){
+
+    /*
+        Richiede: strutture dati albero binario non nulle
+        Effetto: restituisce un nuovo albero, perfettamente bilanciato e con la stessa modalità e lo stesso
+                    aggregato di a,
+                    che contiene le coppie chiave-valore di entrambi gli alberi (a parità di chiave
+                    precedono quelle di a). Le due visite in ordine vengono fuse direttamente nei nodi
+                    del nuovo albero, allocati in un unico blocco: il costo è O(nnodes(a) + nnodes(b)).
+                    Gli alberi a e b non vengono modificati; i valori sono condivisi e non copiati.
+    */
+
+    struct binstree *tree;
+    struct node *nodes, *x, *y, *from;
+    unsigned int n, i;
+
+    assert(a != NULL && b != NULL);
+
+    tree = newtreeAggregate(a->mode, a->combine, a->identity);
+
+    if ((n = a->nnodes + b->nnodes) == 0) return tree;
+
+    nodes = allocBlock(tree, n);
+
+    for (i = 0, x = leftmost(a->radix), y = leftmost(b->radix); x != NULL || y != NULL; i++){
+
+        if (y == NULL || (x != NULL && x->key <= y->key)) from = x, x = successor(x, NULL);
+
+        else from = y, y = successor(y, NULL);
+
+        nodes[i].key = from->key;
+        nodes[i].value = from->value;
+
+    }
+
+    tree->radix = build(tree, nodes, NULL, NULL, 0, n, NULL);
+    tree->nnodes = n;
+
+    return tree;
+
+}
+
+// Restituisce il sottoalbero la cui radice corrisponde al valore passato come parametro
+struct binstree* subtree(struct binstree *tree, unsigned int key){
+    
+    struct node *ptop;
+    struct binstree *subtree;
+
+    // Verifica che l'oggetto da cercare non sia nullo
+    assert(tree != NULL);
+
+    if ((ptop = findNode(tree->radix, key)) == NULL) return NULL;
+
+    // Assegna come radice del sottoalbero il nodo il cui valore è item
+    (subtree = newtree())->radix = ptop;
+    // Restituisce il sottoalbero creato
+    return subtree;
+
+}
+
+void* search(struct binstree* tree, unsigned int key){
+
+    struct node *n;
+
+    assert(tree != NULL);
+
+    // Cerca direttamente il nodo, senza allocare un sottoalbero come subtree
+    return (n = findNode(tree->radix, key)) != NULL ? n->value : NULL;
+
+}
+
+int isin(struct binstree *tree, unsigned int key){
+
+    assert(tree != NULL);
+
+    return findNode(tree->radix, key) != NULL ? TRUE : FALSE;
+
+}
+
+// Ricerca a partire dal nodo finger, in cui è terminata la ricerca di una chiave <= key (NULL per la prima):
+// risale finchè non raggiunge un nodo figlio sinistro di un padre con chiave > key, l'unico antenato
+// il cui sottoalbero contiene certamente key, quindi scende come search. Restituisce il nodo con la chiave
+// (NULL se assente) e in *finger il nodo in cui la ricerca è terminata. Se finger ha proprio chiave key riparte
+// dalla radice: con chiavi duplicate restituisce così, come search, la prima chiave uguale sul cammino dalla radice
+static struct node* fingerSearch(struct binstree *tree, struct node **finger, unsigned int key){
+
+    struct node *node = *finger, *last;
+
+    if (node == NULL || node->key == key) node = tree->radix;
+
+    else while (node->parent != NULL && !(node->parent->sx == node && node->parent->key > key)) node = node->parent;
+
+    for (last = node; node != NULL && node->key != key; node = node->key > key ? node->sx : node->dx) last = node;
+
+    *finger = node != NULL ? node : last;
+
+    return node;
+
+}
+
+void searchBatch(struct binstree *tree, unsigned int *keys, unsigned int n, void **out){
+
+    /*
+        Richiede: struttura dati albero binario non nulla, array keys di n chiavi, array out di n elementi
+        Effetto: scrive in out[i] il valore associato a keys[i], NULL se la chiave non è presente
+                    (lo stesso risultato di search per ciascuna chiave), senza allocare memoria.
+                    Se le chiavi sono in ordine non decrescente ogni ricerca riparte dal nodo in cui è
+                    terminata la precedente, risalendo solo fino al primo antenato che contiene la chiave:
+                    chiavi vicine condividono quasi tutto il cammino. Altrimenti le ricerche procedono a gruppi
+                    di SEARCH_BATCH, un livello alla volta, caricando in anticipo i nodi del livello successivo
+                    così che le attese della memoria delle diverse chiavi si sovrappongano.
+    */
+
+    struct node *lane[SEARCH_BATCH], *finger = NULL, *node;
+    unsigned int i, b, width, active;
+
+    assert(tree != NULL && (n == 0 || (keys != NULL && out != NULL)));
+
+    for (i = 1; i < n && keys[i - 1] <= keys[i]; i++);
+
+    if (i >= n){
+
+        // Una chiave ripetuta ha lo stesso risultato della precedente, senza ripartire dalla radice
+        for (i = 0; i < n; i++)
+
+            out[i] = i > 0 && keys[i] == keys[i - 1] ? out[i - 1] : (node = fingerSearch(tree, &finger, keys[i])) != NULL ? node->value : NULL;
+
+        return;
+
+    }
+
+    for (b = 0; b < n; b += SEARCH_BATCH){
+
+        width = n - b < SEARCH_BATCH ? n - b : SEARCH_BATCH;
+
+        for (i = 0; i < width; i++) lane[i] = tree->radix;
+
+        // Ogni passo fa scendere di un livello tutte le ricerche non ancora terminate
+        do {
+
+            for (active = 0, i = 0; i < width; i++){
+
+                if ((node = lane[i]) == NULL || node->key == keys[b + i]) continue;
+
+                if ((lane[i] = (node->key > keys[b + i] ? node->sx : node->dx)) != NULL){
+
+                    __builtin_prefetch(lane[i]);
+
+                    active++;
+
+                }
+
+            }
+
+        } while (active > 0);
+
+        for (i = 0; i < width; i++) out[b + i] = lane[i] != NULL ? lane[i]->value : NULL;
+
+    }
+
+}
+
+void delete(struct binstree *tree, unsigned int key){
+
+    /*
+        Richiede: struttura dati albero binario non nulla
+        Effetto: rimuove dall'albero un nodo con la chiave passata come parametro, se presente.
+                    In modalità BINSTREE_AVL l'albero viene ribilanciato risalendo dal padre del nodo rimosso.
+    */
+
+    struct node *node, *child, *parent;
+
+    assert(tree != NULL);
+
+    for (node = tree->radix; node != NULL && node->key != key; node = node->key > key ? node->sx : node->dx);
+
+    // La chiave non appartiene all'albero
+    if (node == NULL) return;
+
+    // Se il nodo ha due figli assume chiave e valore del predecessore, ossia il massimo del sottoalbero sinistro,
+    // che viene rimosso al suo posto. Nota che essendo il massimo non può avere un figlio destro
+    if (node->sx != NULL && node->dx != NULL){
+
+        for (child = node->sx; child->dx != NULL; child = child->dx);
+
+        node->key = child->key;
+        node->value = child->value;
+
+        node = child;
+
+    }
+
+    // Il nodo ha al più un figlio, che prende il suo posto (anche quando il nodo è la radice)
+    child = node->sx != NULL ? node->sx : node->dx;
+    parent = node->parent;
+
+    *linkOf(tree, node) = child;
+
+    if (child != NULL) child->parent = parent;
+
+    freeNode(tree, node);
+
+    // Diminuisce di uno il n. di nodi dell'albero e di ciascun sottoalbero che conteneva il nodo
+    tree->nnodes--;
+
+    for (child = parent; child != NULL; child = child->parent) child->size--;
+
+    if (tree->mode == BINSTREE_AVL) retrace(tree, parent);
+
+    refreshPath(tree, parent);
+
+}
+
+struct pair* pred(struct binstree* tree, unsigned int key){
+
+    struct binstree *subt, *temp;
+    struct node *parent, *ptru;
+    struct pair *ppred;
+
+    assert(tree != NULL);
+
+    if ((subt = subtree(tree, key)) != NULL) {
+
+        if ((ptru = subt->radix)->sx == NULL){
+
+            while((parent = ptru->parent) != NULL && ptru->key < key) 
+            
+                ptru = parent;
+            
+            ppred = smalloc(sizeof(struct pair));
+            ppred->key=parent->key;
+            ppred->value=parent->value;
+
+        }
+
+        else {
+
+            (temp = newtree())->radix = ptru->sx;
+
+            ppred = max(temp);
+
+            free(temp);
+
+        }
+
+        free(subt);
+
+        return ppred;
+
+    }
+
+}
+
+struct pair* parent(struct binstree* tree, unsigned int key){
+
+    /*  
+        Richiede: struttura dati albero binario non nulla, chiave di ricerca (unsigned int)
+        Effetto: Restituisce il padre del nodo a cui è associata la chiave passata come parametro;
+                    se la chiave non esiste restituisce NULL.
+    */
+    
+    struct pair *pair;
+    struct node *n;
+    struct binstree* sbt;
+
+    assert(tree != NULL);
+
+    // In questo caso subtree funziona come una search, restituisce però il sottoalbero
+    // alla cui radice appartiene la chiave passata come parametro della funzione.
+    // Nota che se subtree è nullo, significa che la chiave non esiste.
+    if ((sbt = subtree(tree, key)) != NULL) {
+
+        *(pair = smalloc(sizeof(struct pair))) = (struct pair){
+            .key=sbt->radix->key,
+            .value=sbt->radix->value
+        };
+
+        // Dealloco lo spazio del sottoalbero generato dalla funzione subtree
+        free(sbt);
+
+        // Restituisce la coppia chiave-valore del nodo padre
+        return pair;
+
+    }
+
+    return NULL;
+
+}
+
+struct pair* max(struct binstree *tree){
+
+    /* 
+        Richiesto: struttura dati albero binario non nulla
+        Effetto: Restituisce la struttura coppia chiave-valore i cui valori corrispondono alla 
+                    massima chiave contenuta nell'albero e il relativo valore.
+                    Nota che la chiave massima dell'albero è per definizione di 
+                    albero binario di ricerca, il nodo destro più profondo del sottoalbero destro.
+    */
+    
+    // ptru contiene l'indirizzo in memoria del PUNTATORE alla radice dell'albero
+    struct node *ptru;
+    struct pair *p;
+
+    assert(tree != NULL);
+
+    if((ptru = tree->radix) != NULL){
+    
+        // Finchè non raggiunge la profondità massima del sottoalbero sinistro continua
+        while (ptru->dx != NULL) ptru = ptru->dx;
+
+        // Crea la struttura dati contenente la coppia chiave-valore
+        *(p = smalloc(sizeof(struct pair))) = (struct pair){
+            .key=ptru->key,
+            .value=ptru->value
+        };
+
+        return p;
+
+    }
+
+    return NULL;
+
+}
+
+struct pair* min(struct binstree *tree){
+
+    /* 
+        Richiesto: struttura dati albero binario non nulla
+        Effetto: Restituisce la struttura coppia chiave-valore i cui valori corrispondono alla 
+                    minima chiave contenuta nell'albero e il relativo valore.
+                    Nota che la chiave minima dell'albero è per definizione di 
+                    albero binario di ricerca, il nodo sinistro più profondo del sottoalbero sinistro.
+    */
+
+    // node_pointer contiene l'indirizzo in memoria del PUNTATORE alla radice dell'albero
+    struct node *ptru;
+    struct pair *p;
+
+    assert(tree != NULL);
+
+    if ((ptru = tree->radix) != NULL){
+
+        // Finchè non raggiunge la profondità massima del sottoalbero sinistro continua
+        while (ptru->sx != NULL) ptru = ptru->sx;
+
+        // Crea la struttura dati contenente la coppia chiave-valore
+        *(p = smalloc(sizeof(struct pair))) = (struct pair){
+            .key=ptru->key,
+            .value=ptru->value
+        };
+
+        return p;
+
+    }
+
+    return NULL;
+
+}
+
+void destroyTree(struct binstree *tree){
+
+    /* 
+        Richiede: struttura dati albero binario non nulla
+        Effetto: dealloca lo spazio riservato a ciascun nodo dell'albero
+                    e alla struttura dati stessa.
+                    I nodi vengono liberati insieme alle slab da cui sono stati ricavati,
+                    senza visitare l'albero.
+
+        Attenzione: non dealloca lo spazio riservato al valore contenuto in ciascun nodo!
+    */
+    
+    struct slab *slab, *next;
+    
+    // Verifica che la struttura dati passata non sia nulla
+    assert(tree != NULL);
+
+    for (slab = tree->slabs; slab != NULL; slab = next){
+
+        next = slab->next;
+
+        free(slab);
+
+    }
+
+    // Libera lo spazio di memoria allocato per la struttura albero
+    free(tree);
+
+}
+
+int maxdepth(struct binstree *tree){
+
+    assert(tree != NULL);
+
+    // In modalità bilanciata l'altezza è già memorizzata nella radice
+    if (tree->mode == BINSTREE_AVL) return height(tree->radix);
+
+    struct code *level = newcode();
+    struct node *temp = tree->radix, *last = temp;
+    int depth=0;
+
+    if (temp != NULL) enqueue(level, temp);
+
+    while(!isCodeEmpty(level)){
+
+        temp = dequeue(level);
+
+        if (last == NULL) last = temp;
+
+        if (temp->key == last->key){
+
+            if (temp->sx != NULL) enqueue(level, (last = temp->sx));
+
+            if (temp->dx != NULL) enqueue(level, (last = temp->dx));
+
+            if (temp->sx == NULL && temp->dx == NULL) last = NULL;
+
+            depth++;
+
+        }
+
+        else{
+            
+            if (temp->sx != NULL) enqueue(level, temp->sx);
+
+            if (temp->dx != NULL) enqueue(level, temp->dx);
+
+        }
+
+    }
+
+    destroyCode(level);
+
+    return depth;
+
+}
+
+// Trasforma in una catena la parte destra del nodo pseudo con una serie di rotazioni a destra
+// (ciascun nodo diventa il figlio destro del precedente in ordine) e restituisce il numero di nodi
+static unsigned int treeToVine(struct binstree *tree, struct node *pseudo){
+
+    struct node *tail = pseudo, *rest = pseudo->dx;
+    unsigned int size = 0;
+
+    while (rest != NULL){
+
+        // Il nodo non ha figlio sinistro: è già al suo posto nella catena
+        if (rest->sx == NULL){
+
+            tail = rest;
+            rest = rest->dx;
+
+            size++;
+
+        }
+
+        // Altrimenti il figlio sinistro sale al posto del nodo
+        else {
+
+            rotateRight(tree, &(tail->dx));
+
+            rest = tail->dx;
+
+        }
+
+    }
+
+    return size;
+
+}
+
+// Esegue count rotazioni a sinistra alternate lungo la catena, dimezzandone la lunghezza
+static void compress(struct binstree *tree, struct node *pseudo, unsigned int count){
+
+    struct node *scanner = pseudo;
+
+    for (unsigned int i=0; i<count; i++){
+
+        rotateLeft(tree, &(scanner->dx));
+
+        scanner = scanner->dx;
+
+    }
+
+}
+
+void balance(struct binstree* tree){
+
+    /*
+        Richiesto: struttura dati albero binario non nullo
+        Effetto: modifica l'albero rendendolo perfettamente bilanciato: tutti i livelli sono completi
+                    tranne al più l'ultimo, quindi per ogni nodo la differenza della profondità tra il
+                    sottoalbero sinistro (sx) e il sottoalbero destro (dx) è compresa tra -1 e +1.
+
+                    -1 <= depth(sx) - depth(dx) <= +1
+
+                    Utilizza l'algoritmo di Day-Stout-Warren: l'albero viene prima trasformato in una catena
+                    ordinata e poi ricompattato con rotazioni a sinistra; richiede tempo O(n), spazio aggiuntivo
+                    costante e nessuna ricorsione.
+                    Un albero in modalità BINSTREE_AVL è sempre bilanciato e non viene modificato.
+    */
+
+    // Pseudo radice: il suo figlio destro è la radice dell'albero durante la ristrutturazione
+    struct node pseudo = { .dx=NULL, .sx=NULL, .parent=NULL };
+    unsigned int size, leaves, full;
+
+    assert (tree != NULL);
+
+    if (tree->mode == BINSTREE_AVL || tree->radix == NULL) return;
+
+    pseudo.dx = tree->radix;
+
+    size = treeToVine(tree, &pseudo);
+
+    // full è il numero di nodi del più grande albero completo che non supera size: i nodi in eccesso
+    // formano l'ultimo livello e vengono sistemati con il primo passaggio
+    for (full = 1; full <= size; full = full * 2 + 1);
+
+    leaves = size - full / 2;
+
+    compress(tree, &pseudo, leaves);
+
+    for (size -= leaves; size > 1; size /= 2) compress(tree, &pseudo, size / 2);
+
+    (tree->radix = pseudo.dx)->parent = NULL;
+
+}
+
+void RRRotation(struct binstree *tree){
+
+    /* 
+        Richiesto: Struttura albero binario non nulla
+        Effetto: Modifica l'albero passato come parametro effettuando una rotazione 
+                    a destra della radice e del figlio sinistro della radice
+
+                    e.g. albero iniziale:   8       albero dopo RRRotation:   5
+                                           /                                 / \
+                                          5                                 1   8
+                                         / \                                   /
+                                        1   6                                 6
+    */
+
+    assert(tree != NULL);
+
+    rotateRight(tree, &(tree->radix));
+
+}
+
+void LLRotation(struct binstree *tree){
+
+    /*
+        Richiesto: Struttura albero binario non nulla
+        Effetto: Modifica l'albero passato come parametro effettuando una rotazione
+                    a sinistra della radice e del figlio destro della radice
+
+                    e.g. albero iniziale:   7        albero dopo LLRotation:   9
+                                             \                                / \
+                                              9                              7  10
+                                             / \                              \
+                                            8  10                              8
+     */
+
+    assert(tree != NULL);
+
+    rotateLeft(tree, &(tree->radix));
+
+}
+
+void RLRotation(struct binstree *tree){
+
+    /*
+        Richiesto: struttura albero binario non nulla
+        Effetto: Modifica l'albero passato come parametro effettuando una rotazione doppia
+    */
+
+    assert(tree != NULL);
+
+    rotateRight(tree, &(tree->radix->dx));
+
+    rotateLeft(tree, &(tree->radix));
+
+}
+
+void LRRotation(struct binstree *tree){
+
+    /*
+        Richiesto: struttura albero binario non nulla
+        Effetto: Modifica l'albero passato come parametro effettuando una rotazione doppia
+    */
+
+    assert(tree != NULL);
+
+    rotateLeft(tree, &(tree->radix->sx));
+
+    rotateRight(tree, &(tree->radix));
+
+}
+
+// Copia i nodi, a partire da node e seguendo la visita in ordine, nel sottoalbero di Eytzinger di radice i;
+// restituisce il primo nodo non ancora copiato
+static struct node* eytzinger(struct frozentree *frozen, struct node *node, unsigned int i){
+
+    if (i > frozen->n) return node;
+
+    node = eytzinger(frozen, node, 2 * i);
+
+    frozen->keys[i] = node->key;
+    frozen->values[i] = node->value;
+
+    return eytzinger(frozen, successor(node, NULL), 2 * i + 1);
+
+}
+
+// Posizione della prima chiave >= key, 0 se tutte le chiavi sono minori.
+// Nella discesa ogni passo a destra aggiunge un bit 1 a i e ogni passo a sinistra un bit 0: l'ultimo
+// passo a sinistra corrisponde al nodo cercato e si ottiene eliminando gli 1 finali e lo 0 che li precede
+static inline unsigned int frozenLowerBound(struct frozentree *frozen, uint32_t key){
+
+    unsigned long i = 1;
+
+    while (i <= frozen->n){
+
+        // Carica in anticipo la linea che contiene i discendenti di i a quattro livelli di distanza
+        __builtin_prefetch(frozen->keys + (16 * i < frozen->capacity ? 16 * i : 0));
+
+        i = 2 * i + (frozen->keys[i] < key);
+
+    }
+
+    return i >> __builtin_ffsl(~i);
+
+}
+
+struct frozentree* freezeTree(struct binstree *tree){
+
+    /*
+        Richiede: struttura dati albero binario non nulla
+        Effetto: restituisce una copia immutabile dell'albero, indipendente da esso, con le chiavi disposte
+                    in un unico array contiguo in ordine di Eytzinger (visita in ampiezza di un albero
+                    perfettamente bilanciato). frozenSearch non segue puntatori e non contiene salti
+                    dipendenti dai confronti, quindi è molto più veloce di search sugli alberi costruiti
+                    una volta e interrogati molte volte. Richiede tempo O(n).
+    */
+
+    struct frozentree *frozen;
+    unsigned int capacity;
+
+    assert(tree != NULL);
+
+    for (capacity = 16; capacity <= tree->nnodes; capacity <<= 1);
+
+    frozen = smalloc(sizeof(struct frozentree));
+    frozen->n = tree->nnodes;
+    frozen->capacity = capacity;
+    frozen->map = NULL;
+    frozen->maplength = 0;
+    frozen->values = smalloc(((size_t) tree->nnodes + 1) * sizeof(void*));
+
+    if ((frozen->keys = aligned_alloc(64, capacity * sizeof(uint32_t))) == NULL){
+
+        fprintf(stderr, "Memory allocation error\n");
+
+        exit(0);
+
+    }
+
+    frozen->keys[0] = 0;
+    frozen->values[0] = NULL;
+
+    eytzinger(frozen, leftmost(tree->radix), 1);
+
+    for (unsigned int i = frozen->n + 1; i < capacity; i++) frozen->keys[i] = UINT32_MAX;
+
+    return frozen;
+
+}
+
+void* frozenSearch(struct frozentree *frozen, unsigned int key){
+
+    /*
+        Richiede: struttura restituita da freezeTree
+        Effetto: restituisce il valore associato alla chiave, NULL se la chiave non è presente
+    */
+
+    unsigned int i;
+
+    assert(frozen != NULL);
+
+    i = frozenLowerBound(frozen, key);
+
+    return i != 0 && frozen->keys[i] == key ? frozen->values[i] : NULL;
+
+}
+
+void frozenSearchBatch(struct frozentree *frozen, unsigned int *keys, unsigned int n, void **out){
+
+    /*
+        Richiede: struttura restituita da freezeTree, array keys di n chiavi, array out di n elementi
+        Effetto: scrive in out[i] il valore associato a keys[i], NULL se la chiave non è presente.
+                    Le ricerche procedono a gruppi di FROZEN_BATCH, un livello alla volta, così che i
+                    caricamenti dalla memoria delle diverse chiavi si sovrappongano.
+    */
+
+    unsigned long pos[FROZEN_BATCH];
+    unsigned int levels, width, b, j;
+
+    assert(frozen != NULL && (n == 0 || (keys != NULL && out != NULL)));
+
+    // Tutti i livelli tranne l'ultimo sono completi: ogni ricerca esegue levels - 1 passi e al più un ultimo passo
+    for (levels = 0; (1UL << levels) <= frozen->n; levels++);
+
+    for (b = 0; b < n; b += FROZEN_BATCH){
+
+        width = n - b < FROZEN_BATCH ? n - b : FROZEN_BATCH;
+
+        for (j = 0; j < width; j++) pos[j] = 1;
+
+        for (unsigned int level = 0; level < levels; level++){
+
+            for (j = 0; j < width; j++){
+
+                // Una ricerca arrivata oltre n è terminata e non legge più l'array
+                pos[j] = pos[j] <= frozen->n ? 2 * pos[j] + (frozen->keys[pos[j]] < keys[b + j]) : pos[j];
+
+                __builtin_prefetch(frozen->keys + (pos[j] < frozen->capacity ? pos[j] : 0));
+
+            }
+
+        }
+
+        for (j = 0; j < width; j++){
+
+            pos[j] >>= __builtin_ffsl(~pos[j]);
+
+            out[b + j] = pos[j] != 0 && frozen->keys[pos[j]] == keys[b + j] ? frozen->values[pos[j]] : NULL;
+
+        }
+
+    }
+
+}
+
+void destroyFrozenTree(struct frozentree *frozen){
+
+    /*
+        Richiede: struttura restituita da freezeTree o da mapTree
+        Effetto: dealloca lo spazio riservato alla copia (o chiude la mappatura del file);
+                    l'albero originale non viene modificato.
+    */
+
+    assert(frozen != NULL);
+
+    if (frozen->map != NULL) munmap(frozen->map, frozen->maplength);
+
+    else {
+
+        free(frozen->keys);
+        free(frozen->values);
+
+    }
+
+    free(frozen);
+
+}
+
+
+/* -------------------------------- Salvataggio su file -------------------------------- */
+
+#define CHECKSUM_SEED 0xcbf29ce484222325ULL
+#define ALIGN8(n) (((n) + 7) & ~((uint64_t) 7))
+#define ALIGN64(n) (((n) + 63) & ~((uint64_t) 63))
+
+// FNV-1a calcolato su parole di 64 bit; l'ultima parola incompleta viene completata con zeri,
+// come avviene per il riempimento che allinea ogni blocco del file a 8 byte
+static uint64_t checksum(uint64_t sum, const void *data, uint64_t length){
+
+    const unsigned char *bytes = data;
+    uint64_t word, i;
+
+    for (i = 0; i < length; i += 8){
+
+        word = 0;
+
+        memcpy(&word, bytes + i, length - i < 8 ? length - i : 8);
+
+        sum = (sum ^ word) * 0x100000001b3ULL;
+
+    }
+
+    return sum;
+
+}
+
+// Scrive un blocco seguito dagli zeri necessari ad allinearlo a 8 byte e ne aggiorna il checksum
+static int writeBlock(FILE *file, const void *data, uint64_t length, uint64_t *sum){
+
+    static const char padding[8] = { 0 };
+
+    *sum = checksum(*sum, data, length);
+
+    return fwrite(data, 1, length, file) == length && fwrite(padding, 1, ALIGN8(length) - length, file) == ALIGN8(length) - length;
+
+}
+
+// Lunghezza delle sezioni keys e handles, che iniziano subito dopo l'intestazione
+static inline uint64_t sortedSections(const struct treefile *header){
+
+    return ALIGN8(header->keybytes) + header->count * sizeof(uint64_t);
+
+}
+
+// Mappa in sola lettura un file prodotto da saveTree e ne controlla l'intestazione (e il checksum se verify
+// è vero); restituisce l'intestazione all'inizio della mappatura oppure NULL
+static const struct treefile* mapTreeFile(const char *path, int verify, unsigned long *length){
+
+    const struct treefile *header;
+    struct stat info;
+    uint64_t sections;
+    void *map;
+    int fd, valid;
+
+    if ((fd = open(path, O_RDONLY)) < 0) return NULL;
+
+    if (fstat(fd, &info) != 0 || (uint64_t) info.st_size < sizeof(struct treefile)
+            || (map = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED){
+
+        close(fd);
+
+        return NULL;
+
+    }
+
+    // La mappatura rimane valida anche dopo la chiusura del descrittore
+    close(fd);
+
+    header = map;
+    sections = sizeof(struct treefile) + sortedSections(header);
+
+    valid = memcmp(header->magic, TREEFILE_MAGIC, sizeof(TREEFILE_MAGIC)) == 0
+            && header->version == TREEFILE_VERSION
+            && header->length == (uint64_t) info.st_size
+            && header->count < UINT32_MAX && header->keybytes <= 5 * header->count
+            && sections <= header->length
+            && (!(header->flags & TREEFILE_LAYOUT) || (header->layout >= sections && header->layout % 64 == 0
+                    && header->capacity > header->count && header->capacity <= 2 * header->count + 16
+                    && header->layout + header->capacity * sizeof(uint32_t) + (header->count + 1) * sizeof(uint64_t) <= header->length))
+            && (!verify || checksum(CHECKSUM_SEED, header + 1, header->length - sizeof(struct treefile)) == header->checksum);
+
+    if (!valid){
+
+        munmap(map, info.st_size);
+
+        return NULL;
+
+    }
+
+    *length = info.st_size;
+
+    return header;
+
+}
+
+int saveTree(struct binstree *tree, const char *path, uint64_t (*handle)(void*), int layout){
+
+    /*
+        Richiede: struttura dati albero binario non nulla, percorso del file
+        Effetto: scrive su file il contenuto dell'albero in un formato compatto, versionato e privo di
+                    puntatori: le chiavi in ordine crescente codificate come differenze varint (da 1 a 5 byte
+                    ciascuna) e per ogni valore l'handle restituito dalla funzione handle, oppure il valore
+                    stesso convertito in intero se handle è NULL. Se layout è vero aggiunge la copia in
+                    layout di Eytzinger che mapTree interroga direttamente sul file.
+                    loadTree ricostruisce l'albero in tempo O(n). Restituisce True se il file è stato scritto correttamente.
+    */
+
+    static const uint64_t zero = 0;
+    struct treefile header;
+    struct frozentree *frozen = NULL;
+    struct node *node;
+    unsigned char *keys;
+    uint64_t *handles, i;
+    uint32_t previous, delta;
+    FILE *file;
+    int ok;
+
+    assert(tree != NULL && path != NULL);
+
+    // Le dimensioni vanno calcolate in size_t: con centinaia di milioni di nodi non stanno in un unsigned int
+    keys = smalloc(5 * (size_t) tree->nnodes + 1);
+    handles = smalloc(((size_t) tree->nnodes + 1) * sizeof(uint64_t));
+
+    memset(&header, 0, sizeof(struct treefile));
+    memcpy(header.magic, TREEFILE_MAGIC, sizeof(TREEFILE_MAGIC));
+
+    header.version = TREEFILE_VERSION;
+    header.count = tree->nnodes;
+
+    for (i = 0, previous = 0, node = leftmost(tree->radix); node != NULL; i++, previous = node->key, node = successor(node, NULL)){
+
+        for (delta = node->key - previous; delta >= 0x80; delta >>= 7) keys[header.keybytes++] = (delta & 0x7F) | 0x80;
+
+        keys[header.keybytes++] = delta;
+
+        handles[i] = handle != NULL ? handle(node->value) : (uint64_t) (uintptr_t) node->value;
+
+    }
+
+    header.length = sizeof(struct treefile) + sortedSections(&header);
+
+    if (layout){
+
+        frozen = freezeTree(tree);
+
+        header.flags |= TREEFILE_LAYOUT;
+        header.capacity = frozen->capacity;
+        header.layout = ALIGN64(header.length);
+        header.length = header.layout + ALIGN8(frozen->capacity * sizeof(uint32_t)) + (frozen->n + 1) * sizeof(uint64_t);
+
+    }
+
+    header.checksum = CHECKSUM_SEED;
+
+    if ((ok = (file = fopen(path, "wb")) != NULL)){
+
+        ok = fwrite(&header, sizeof(struct treefile), 1, file) == 1
+                && writeBlock(file, keys, header.keybytes, &(header.checksum))
+                && writeBlock(file, handles, header.count * sizeof(uint64_t), &(header.checksum));
+
+        if (ok && frozen != NULL){
+
+            // Le sezioni precedenti terminano a multipli di 8: il riempimento fino all'offset layout è fatto di parole nulle
+            for (i = sizeof(struct treefile) + sortedSections(&header); ok && i < header.layout; i += 8)
+
+                ok = writeBlock(file, &zero, sizeof(uint64_t), &(header.checksum));
+
+            for (i = 0; i <= frozen->n; i++) handles[i] = handle != NULL && i > 0 ? handle(frozen->values[i]) : (uint64_t) (uintptr_t) frozen->values[i];
+
+            ok = ok && writeBlock(file, frozen->keys, frozen->capacity * sizeof(uint32_t), &(header.checksum))
+                    && writeBlock(file, handles, (frozen->n + 1) * sizeof(uint64_t), &(header.checksum));
+
+        }
+
+        // Riscrive l'intestazione con il checksum definitivo
+        ok = ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(struct treefile), 1, file) == 1;
+        ok = fclose(file) == 0 && ok;
+
+    }
+
+    if (frozen != NULL) destroyFrozenTree(frozen);
+
+    free(keys);
+    free(handles);
+
+    return ok ? TRUE : FALSE;
+
+}
+
+struct binstree* loadTree(const char *path, int mode, void* (*resolve)(uint64_t), int verify){
+
+    /*
+        Richiede: percorso di un file prodotto da saveTree, modalità BINSTREE_PLAIN oppure BINSTREE_AVL
+        Effetto: restituisce un nuovo albero, perfettamente bilanciato, con il contenuto del file: ogni handle
+                    viene convertito nel valore da resolve, oppure riconvertito in puntatore se resolve è NULL.
+                    Le chiavi vengono decodificate in sequenza direttamente nei nodi del nuovo albero,
+                    allocati in un unico blocco, senza confronti né ribilanciamenti: il costo è O(n).
+                    Se verify è vero controlla anche il checksum. Restituisce NULL se il file non esiste o non è valido.
+    */
+
+    const struct treefile *header;
+    const unsigned char *keys, *end;
+    const uint64_t *handles;
+    struct binstree *tree;
+    struct node *nodes;
+    unsigned long length;
+    uint32_t key, delta;
+    uint64_t i = 0;
+    int shift;
+
+    assert(path != NULL);
+
+    if ((header = mapTreeFile(path, verify, &length)) == NULL) return NULL;
+
+    posix_madvise((void*) header, length, POSIX_MADV_SEQUENTIAL);
+
+    keys = (const unsigned char*) (header + 1);
+    end = keys + header->keybytes;
+    handles = (const uint64_t*) (keys + ALIGN8(header->keybytes));
+
+    tree = newtreeMode(mode);
+
+    if (header->count > 0){
+
+        nodes = allocBlock(tree, header->count);
+
+        for (i = 0, key = 0; i < header->count; i++){
+
+            // Decodifica la differenza dalla chiave precedente
+            for (delta = 0, shift = 0; keys < end && (*keys & 0x80) && shift < 28; keys++, shift += 7) delta |= (uint32_t) (*keys & 0x7F) << shift;
+
+            // Un file troncato o una differenza che non sta in 32 bit (quinto byte con bit di continuazione
+            // o con bit oltre il trentaduesimo) interrompono la decodifica
+            if (keys == end || (shift == 28 && *keys > 0x0F)) break;
+
+            delta |= (uint32_t) *(keys++) << shift;
+
+            // Le chiavi sono in ordine crescente: una chiave che supera UINT_MAX non è valida
+            if (key + delta < key) break;
+
+            nodes[i].key = (key += delta);
+            nodes[i].value = resolve != NULL ? resolve(handles[i]) : (void*) (uintptr_t) handles[i];
+
+        }
+
+    }
+
+    // Il file è valido solo se tutte le chiavi sono state decodificate usando esattamente keybytes byte
+    if (i < header->count || keys != end){
+
+        destroyTree(tree);
+
+        munmap((void*) header, length);
+
+        return NULL;
+
+    }
+
+    if (header->count > 0){
+
+        tree->radix = build(tree, nodes, NULL, NULL, 0, header->count, NULL);
+        tree->nnodes = header->count;
+
+    }
+
+    munmap((void*) header, length);
+
+    return tree;
 
 }
 
-int maxdepth(struct binstree *tree){
+struct frozentree* mapTree(const char *path, int verify){
 
-    assert(tree != NULL);
+    /*
+        Richiede: percorso di un file prodotto da saveTree con layout vero
+        Effetto: mappa il file in memoria in sola lettura e restituisce una copia immutabile dell'albero
+                    su cui frozenSearch e frozenSearchBatch operano direttamente sul file, senza ricostruirlo:
+                    i valori restituiti sono gli handle salvati, convertiti in puntatore.
+                    Le pagine del file sono condivise tra tutti i processi che lo mappano.
+                    Se verify è vero controlla anche il checksum. Restituisce NULL se il file non esiste,
+                    non è valido o non contiene il layout di Eytzinger.
+    */
 
-    struct code *level = newcode();
-    struct node *temp = tree->radix, *last = temp;
-    int depth=0;
+    const struct treefile *header;
+    struct frozentree *frozen;
+    unsigned long length;
 
-    if (temp != NULL) enqueue(level, temp);
+    assert(path != NULL);
 
-    while(!isCodeEmpty(level)){
+    if ((header = mapTreeFile(path, verify, &length)) == NULL) return NULL;
 
-        temp = dequeue(level);
+    // Gli handle a 64 bit vengono letti come puntatori solo dove hanno la stessa dimensione
+    if (!(header->flags & TREEFILE_LAYOUT) || sizeof(void*) != sizeof(uint64_t)){
 
-        if (last == NULL) last = temp;
+        munmap((void*) header, length);
 
-        if (temp->key == last->key){
+        return NULL;
 
-            if (temp->sx != NULL) enqueue(level, (last = temp->sx));
+    }
 
-            if (temp->dx != NULL) enqueue(level, (last = temp->dx));
+    frozen = smalloc(sizeof(struct frozentree));
+    frozen->n = header->count;
+    frozen->capacity = header->capacity;
+    frozen->keys = (uint32_t*) ((char*) header + header->layout);
+    frozen->values = (void**) ((char*) header + header->layout + ALIGN8(header->capacity * sizeof(uint32_t)));
+    frozen->map = (void*) header;
+    frozen->maplength = length;
 
-            if (temp->sx == NULL && temp->dx == NULL) last = NULL;
+    return frozen;
 
-            depth++;
+}
+
+struct generator* depth_inorder_iter(struct binstree *tree){
+
+    assert(tree != NULL);
+
+    struct code *code = newcode();
+    struct pile *support = newpile();
+    struct node *temp = tree->radix;
+    struct generator *gen = smalloc(sizeof(struct generator));
 
+    // Continua finchè la pila non è vuota
+    while(!isPileEmpty(support) || temp != NULL){
+
+        // Se il nodo non è nullo
+        if (temp != NULL){
+            
+            // Inserisco nella pila l'attuale nodo
+            push(support, temp);
+            // Imposta il nodo attuale al nodo figlio sinistro dell'attuale nodo
+            temp = temp->sx;
+            
         }
 
         else{
-            
-            if (temp->sx != NULL) enqueue(level, temp->sx);
 
-            if (temp->dx != NULL) enqueue(level, temp->dx);
+            // Inserisce l'oggetto nell'array alla posizione indicata dalla variabile position
+            enqueue(code, (temp = pop(support)));
+            // Imposta il nodo attuale al nodo figlio destro dell'attuale nodo
+            temp = temp->dx;
 
         }
 
     }
 
-    destroyCode(level);
+    destroyPile(support);
 
-    return depth;
+    gen->code = code;
+    gen->current_node = dequeue(code);
+    gen->visit = DEPTH_INORDER_VISIT;
+
+    return gen;
 
 }
 
-void balance(struct binstree* tree){
+struct generator* depth_preorder_iter(struct binstree *tree){
 
     /*
-        Richiesto: struttura dati albero binario non nullo
-        Effetto: modifica l'albero bilanciando ricorsivamente ciascun sottoalbero.
-                    Dato un nodo (u), radice dell'albero e rispettivamento il sottoalbero
-                    sinistro (sx) la cui radice è il figlio sinistro di u e il sottoalbero destro (dx)
-                    la cui radice è il figlio destro di u, questi si considerano bilanciati se la differenza
-                    della profondita tra il sottoalbero sinistro e il sottoalbero destro è compresa tra -1 e +1.
+        Richiede: struttura dati albero binario non nulla
+        Effetto: restituisce una struttura generatore tale per cui, ad ogni chiamata di genNext()
+                    si otterrà una visita in preordine.
+                    La visita in preordine visita prima la radice poi il figlio sinistro
+                    e il figlio destro rispettivamente
 
-                    -1 <= depth(sx) - depth(dx) <= +1; altrimenti l'albero è sbilanciato.
-        
-        Attenzione: questo metodo fa uso della ricorsione!
     */
-    
-    struct binstree *subtree_sx, *subtree_dx, *sub2tree_sx, *sub2tree_dx;
-    int balanced_f;
 
-    assert (tree != NULL);
+    struct node *temp;
+    struct pile *pile;
+    struct generator *gen;
 
-    // Inizializzo i sottoalberi sinistro e destro della radice
-    // Sono necessari ai fini della ricorsione poichè vengono passati come parametri
-    // per le funzioni alberi e non nodi
-    (subtree_sx = newtree())->radix = tree->radix->sx;
-    (subtree_dx = newtree())->radix = tree->radix->dx;
-
-    // Recursion
-    if (subtree_sx->radix != NULL) balance(subtree_sx);
-    if (subtree_dx->radix != NULL) balance(subtree_dx);
-
-    // La modifica sul bilanciamento ha effetto sui sottoalberi ma il puntatore al figlio
-    // sinistro o destro della radice continua a puntare al valore iniziale
-    // Per questo assegno come nuovi puntatori i valori delle radici del sottoalbero
-    tree->radix->sx = subtree_sx->radix;
-    tree->radix->dx = subtree_dx->radix;
-
-    // Reserve memory (Questi sottoalberi servono per determinare il tipo di rotazione)
-    sub2tree_dx = newtree();
-    sub2tree_sx = newtree();
-    
-    // Il ciclo prosegue finchè i due sottoalberi non hanno un fattore di bilanciamento compreso tra -1 e 1
-    while(abs((balanced_f = maxdepth(subtree_sx) - maxdepth(subtree_dx))) > 1){
+    assert(tree != NULL);
+
+    if ((temp=tree->radix) != NULL){
+
+        pile = newpile();
         
-        // Sottoalbero sbilanciato a sinistra
-        if (balanced_f > 1){
+        if (temp->dx != NULL) push(pile, temp->dx);
 
-            sub2tree_sx->radix = subtree_sx->radix->sx;
-            sub2tree_dx->radix = subtree_sx->radix->dx;
+        if (temp->sx != NULL) push(pile, temp->sx);
 
-            // Rotazione semplice RR (right-right)
-            if (maxdepth(sub2tree_sx) >= maxdepth(sub2tree_dx)) RRRotation(tree);
-            // Rotazione doppia LR (left-right)
-            else LRRotation(tree);
+    }
 
+    *(gen = smalloc(sizeof(struct generator))) = (struct generator) {
+        .pila=pile,
+        .visit=DEPTH_PREORDER_VISIT, 
+        .current_node=temp
+    };
 
-        }
+    return gen;
 
-        // Sottoalbero sbilanciato a destra
-        else{
+}
 
-            sub2tree_sx->radix = subtree_dx->radix->sx;
-            sub2tree_dx->radix = subtree_dx->radix->dx;
+struct generator* depth_postorder_iter(struct binstree *tree){
 
-            // Rotazione semplice LL (left-left)
-            if (maxdepth(sub2tree_sx) <= maxdepth(sub2tree_dx)) LLRotation(tree);
-            // Rotazione doppia RL (right-left)
-            else RLRotation(tree);
+    assert(tree != NULL);
 
-        }
+    struct node* temp = tree->radix;
+    struct pile *pile = newpile(), *support;
+    struct generator *gen = smalloc(sizeof(struct generator));
+
+    push((support = newpile()), temp);
+
+    while(!isPileEmpty(support)){
+
+        push(pile, (temp = pop(support)));
+
+        if (temp->dx != NULL) push(support, temp->dx);
 
-        // Stesso principio di prima
-        subtree_sx->radix = tree->radix->sx;
-        subtree_dx->radix = tree->radix->dx;
+        if (temp->sx != NULL) push(support, temp->sx);
 
     }
 
-    // Libero la memoria allocata per le due strutture
-    free(sub2tree_dx);
-    free(sub2tree_sx);
+    destroyPile(support);
+       
+    gen->pila = pile;
+    gen->current_node=pop(pile);
+    gen->visit=DEPTH_POSTORDER_VISIT;
 
-    // Libero la memoria allocata per le due strutture
-    free(subtree_sx);
-    free(subtree_dx);
+    return gen;
 
 }
 
-void RRRotation(struct binstree *tree){
+struct generator* breadth_first_iter(struct binstree *tree){
 
-    /* 
-        Richiesto: Struttura albero binario non nulla
-        Effetto: Modifica l'albero passato come parametro effettuando una rotazione 
-                    a destra della radice e del figlio sinistro della radice
+    struct code *code;
+    struct node *temp;
+    struct generator *gen;
 
-                    e.g. albero iniziale:   8       albero dopo RRRotation:   5
-                                           /                                 / \
-                                          5                                 1   8
-                                         / \                                   /
-                                        1   6                                 6
-    */
+    assert(tree != NULL);
+
+    if ((temp = tree->radix) != NULL){
+        
+        code = newcode();
+
+        if (temp->sx != NULL) enqueue(code, temp->sx);
 
-    struct node **topnode, *lchild;
+        if (temp->dx != NULL) enqueue(code, temp->dx);
 
-    assert(tree != NULL);
+    }
 
-    // Estraggo la radice e il figlio sinistro della radice
-    topnode = &(tree->radix), lchild = (*topnode)->sx;
+    *(gen = smalloc(sizeof(struct generator))) = (struct generator){
+        .code=code, 
+        .visit=BREADTH_FIRST_VISIT, 
+        .current_node=temp
+    };
 
-    // Assegno come nuovo figlio sinistro della radice il figlio destro di lchild
-    (*topnode)->sx = lchild->dx;
-    // Assegno come nuovo figlio destro a lchild il nodo radice
-    lchild->dx = *topnode;
-    // La nuova radice dell'albero diventa lchild
-    *topnode = lchild;
+    return gen;
 
 }
 
-void LLRotation(struct binstree *tree){
+// Primo nodo della visita in postordine del sottoalbero: la foglia raggiunta scendendo a sinistra quando possibile
+static struct node* deepestFirst(struct node *node){
+
+    while (node->sx != NULL || node->dx != NULL) node = node->sx != NULL ? node->sx : node->dx;
+
+    return node;
+
+}
+
+// Prosegue la visita in preordine dal nodo, che si trova a profondità depth, senza mai scendere oltre la
+// profondità target, né risalire oltre root; restituisce il primo nodo raggiunto a profondità target, NULL se non ne esistono altri
+static struct node* levelNext(struct node *node, struct node *root, unsigned int depth, unsigned int target){
+
+    do {
+
+        if (depth < target && node->sx != NULL) node = node->sx, depth++;
+
+        else if (depth < target && node->dx != NULL) node = node->dx, depth++;
+
+        else {
+
+            // Risale finchè non trova un antenato con un figlio destro non ancora visitato
+            while (node != root && (node->parent->dx == node || node->parent->dx == NULL))
+
+                node = node->parent, depth--;
+
+            if (node == root) return NULL;
+
+            node = node->parent->dx;
+
+        }
+
+    } while (depth != target);
+
+    return node;
+
+}
+
+void cursorInit(struct cursor *cursor, struct binstree *tree, int visit){
 
     /*
-        Richiesto: Struttura albero binario non nulla
-        Effetto: Modifica l'albero passato come parametro effettuando una rotazione
-                    a sinistra della radice e del figlio destro della radice
+        Richiede: cursore e struttura dati albero binario non nulli, tipo di visita
+        Effetto: prepara il cursore per visitare l'albero secondo il tipo di visita richiesto.
+                    A differenza dei generatori il cursore non alloca memoria: ogni passo segue
+                    i puntatori ai figli e al padre a partire dal nodo corrente.
+                    DEPTH_INORDER_VISIT, DEPTH_PREORDER_VISIT e DEPTH_POSTORDER_VISIT visitano l'albero in
+                    tempo O(n) complessivo; BREADTH_FIRST_VISIT percorre l'albero una volta per livello,
+                    quindi richiede tempo O(n * maxdepth(tree)).
+        Attenzione: il cursore non è più valido se l'albero viene modificato durante la visita.
+    */
 
-                    e.g. albero iniziale:   7        albero dopo LLRotation:   9
-                                             \                                / \
-                                              9                              7  10
-                                             / \                              \
-                                            8  10                              8
-     */
+    assert(cursor != NULL && tree != NULL);
 
-    struct node **topnode, *rchild;
+    cursor->visit = visit;
+    cursor->root = tree->radix;
+    cursor->depth = 0;
+    cursor->bounded = FALSE;
 
-    assert(tree != NULL);
+    if (tree->radix == NULL) cursor->node = NULL;
+
+    else switch (visit){
 
-    // Estraggo la radice e il figlio destro della radice
-    topnode = &(tree->radix), rchild = (*topnode)->dx;
+        case DEPTH_PREORDER_VISIT:
+        case BREADTH_FIRST_VISIT:
+            cursor->node = tree->radix;
+            break;
+
+        case DEPTH_POSTORDER_VISIT:
+            cursor->node = deepestFirst(tree->radix);
+            break;
 
-    // Assegno come nuovo figlio destro della radice il figlio sinistro di rchild
-    (*topnode)->dx = rchild->sx;
-    // Assegno come nuovo figlio sinistro di rchild la radice
-    rchild->sx = *topnode;
-    // La nuova radice dell'albero diventa rchild
-    *topnode = rchild;
+        default:
+            cursor->visit = DEPTH_INORDER_VISIT;
+            cursor->node = leftmost(tree->radix);
+
+    }
 
 }
 
-void RLRotation(struct binstree *tree){
+int cursorNext(struct cursor *cursor, unsigned int *key, void **value){
 
     /*
-        Richiesto: struttura albero binario non nulla
-        Effetto: Modifica l'albero passato come parametro effettuando una rotazione doppia
+        Richiede: cursore inizializzato con cursorInit
+        Effetto: se la visita non è terminata scrive in key e value (se non NULL) la chiave e il valore
+                    del prossimo nodo, avanza il cursore e restituisce TRUE; altrimenti restituisce FALSE.
     */
 
-    struct binstree *subtree_dx;
+    struct node *node, *parent;
 
-    assert(tree != NULL);
+    assert(cursor != NULL);
+
+    if ((node = cursor->node) == NULL) return FALSE;
+
+    if (cursor->bounded && node->key >= cursor->hi){
+
+        cursor->node = NULL;
+
+        return FALSE;
+
+    }
+
+    if (key != NULL) *key = node->key;
+
+    if (value != NULL) *value = node->value;
+
+    switch (cursor->visit){
+
+        case DEPTH_PREORDER_VISIT:
+
+            if (node->sx != NULL || node->dx != NULL) cursor->node = node->sx != NULL ? node->sx : node->dx;
+
+            else {
+
+                // La risalita si ferma alla radice del cursore, che su un sottoalbero non è la radice dell'albero
+                while (node != cursor->root && ((parent = node->parent)->dx == node || parent->dx == NULL)) node = parent;
+
+                cursor->node = node != cursor->root ? node->parent->dx : NULL;
+
+            }
+
+            break;
+
+        case DEPTH_POSTORDER_VISIT:
+
+            // Dopo un figlio sinistro si visita il sottoalbero destro del padre, se esiste, altrimenti il padre
+            if (node == cursor->root) cursor->node = NULL;
+
+            else if ((parent = node->parent)->sx == node && parent->dx != NULL)
+
+                cursor->node = deepestFirst(parent->dx);
+
+            else cursor->node = parent;
+
+            break;
 
-    if ((subtree_dx = subtree(tree, tree->radix->dx->key)) != NULL){
+        case BREADTH_FIRST_VISIT:
 
-        RRRotation(subtree_dx);
+            // Al termine di un livello riparte dalla radice cercando il primo nodo del livello successivo
+            if ((cursor->node = levelNext(node, cursor->root, cursor->depth, cursor->depth)) == NULL)
 
-        tree->radix->dx = subtree_dx->radix;
+                cursor->node = levelNext(cursor->root, cursor->root, 0, ++cursor->depth);
 
-        LLRotation(tree);
+            break;
 
-        free(subtree_dx);
+        default:
+            cursor->node = successor(node, cursor->root);
 
     }
 
+    return TRUE;
+
 }
 
-void LRRotation(struct binstree *tree){
+// Primo nodo della visita in ordine con chiave >= key, NULL se non esiste
+static struct node* lowerBound(struct node *node, unsigned int key){
+
+    struct node *candidate = NULL;
+
+    while (node != NULL){
+
+        if (node->key >= key) candidate = node, node = node->sx;
+
+        else node = node->dx;
+
+    }
+
+    return candidate;
+
+}
+
+void seek(struct cursor *cursor, struct binstree *tree, unsigned int key){
+
+    /*
+        Richiede: cursore e struttura dati albero binario non nulli
+        Effetto: posiziona il cursore, in tempo O(maxdepth(tree)), sulla prima chiave >= key;
+                    le successive chiamate a cursorNext proseguono la visita in ordine fino alla fine dell'albero.
+    */
+
+    cursorInit(cursor, tree, DEPTH_INORDER_VISIT);
+
+    cursor->node = lowerBound(tree->radix, key);
+
+}
+
+void rangeIter(struct cursor *cursor, struct binstree *tree, unsigned int lo, unsigned int hi){
+
+    /*
+        Richiede: cursore e struttura dati albero binario non nulli
+        Effetto: prepara il cursore per visitare in ordine le sole chiavi comprese nell'intervallo [lo, hi):
+                    il posizionamento richiede tempo O(maxdepth(tree)) e ogni passo tempo costante ammortizzato.
+    */
+
+    seek(cursor, tree, lo);
+
+    cursor->bounded = TRUE;
+    cursor->hi = hi;
+
+}
+
+unsigned int rankOf(struct binstree *tree, unsigned int key){
+
+    /*
+        Richiede: struttura dati albero binario non nulla
+        Effetto: restituisce il numero di chiavi dell'albero strettamente minori di key,
+                    in tempo O(maxdepth(tree)) grazie alle dimensioni dei sottoalberi memorizzate nei nodi
+    */
 
-    struct binstree *subtree_sx;
+    struct node *node;
+    unsigned int rank = 0;
 
     assert(tree != NULL);
 
-    if ((subtree_sx = subtree(tree, tree->radix->sx->key)) != NULL){
-
-        LLRotation(subtree_sx);
-
-        tree->radix->sx = subtree_sx->radix;
+    for (node = tree->radix; node != NULL;){
 
-        RRRotation(tree);
+        // Il nodo e il suo sottoalbero sinistro precedono key
+        if (node->key < key) rank += subtreeSize(node->sx) + 1, node = node->dx;
 
-        free(subtree_sx);
+        else node = node->sx;
 
     }
 
+    return rank;
+
 }
 
-struct generator* depth_inorder_iter(struct binstree *tree){
+int selectKth(struct binstree *tree, unsigned int k, unsigned int *key, void **value){
 
-    assert(tree != NULL);
+    /*
+        Richiede: struttura dati albero binario non nulla
+        Effetto: se k < nnodes(tree) scrive in key e value (se non NULL) la chiave di posizione k nell'ordine
+                    crescente (k = 0 è la minima) e il valore associato e restituisce TRUE,
+                    altrimenti restituisce FALSE. Richiede tempo O(maxdepth(tree)).
+    */
 
-    struct code *code = newcode();
-    struct pile *support = newpile();
-    struct node *temp = tree->radix;
-    struct generator *gen = smalloc(sizeof(struct generator));
+    struct node *node;
+    unsigned int left;
 
-    // Continua finchè la pila non è vuota
-    while(!isPileEmpty(support) || temp != NULL){
+    assert(tree != NULL);
 
-        // Se il nodo non è nullo
-        if (temp != NULL){
-            
-            // Inserisco nella pila l'attuale nodo
-            push(support, temp);
-            // Imposta il nodo attuale al nodo figlio sinistro dell'attuale nodo
-            temp = temp->sx;
-            
-        }
+    for (node = tree->radix; node != NULL;){
 
-        else{
+        if (k < (left = subtreeSize(node->sx))) node = node->sx;
 
-            // Inserisce l'oggetto nell'array alla posizione indicata dalla variabile position
-            enqueue(code, (temp = pop(support)));
-            // Imposta il nodo attuale al nodo figlio destro dell'attuale nodo
-            temp = temp->dx;
+        else if (k == left) break;
 
-        }
+        else k -= left + 1, node = node->dx;
 
     }
 
-    destroyPile(support);
+    if (node == NULL) return FALSE;
 
-    gen->code = code;
-    gen->current_node = dequeue(code);
-    gen->visit = DEPTH_INORDER_VISIT;
+    if (key != NULL) *key = node->key;
 
-    return gen;
+    if (value != NULL) *value = node->value;
+
+    return TRUE;
 
 }
 
-struct generator* depth_preorder_iter(struct binstree *tree){
+unsigned int countRange(struct binstree *tree, unsigned int lo, unsigned int hi){
 
     /*
         Richiede: struttura dati albero binario non nulla
-        Effetto: restituisce una struttura generatore tale per cui, ad ogni chiamata di genNext()
-                    si otterrà una visita in preordine.
-                    La visita in preordine visita prima la radice poi il figlio sinistro
-                    e il figlio destro rispettivamente
-
+        Effetto: restituisce il numero di chiavi comprese nell'intervallo [lo, hi) in tempo O(maxdepth(tree))
     */
 
-    struct node *temp;
-    struct pile *pile;
-    struct generator *gen;
-
     assert(tree != NULL);
 
-    if ((temp=tree->radix) != NULL){
-
-        pile = newpile();
-        
-        if (temp->dx != NULL) push(pile, temp->dx);
-
-        if (temp->sx != NULL) push(pile, temp->sx);
+    return lo < hi ? rankOf(tree, hi) - rankOf(tree, lo) : 0;
 
-    }
+}
 
-    *(gen = smalloc(sizeof(struct generator))) = (struct generator) {
-        .pila=pile,
-        .visit=DEPTH_PREORDER_VISIT, 
-        .current_node=temp
-    };
+void* aggregateRange(struct binstree *tree, unsigned int lo, unsigned int hi){
 
-    return gen;
+    /*
+        Richiede: albero creato con newtreeAggregate (combine non NULL)
+        Effetto: restituisce l'aggregato, nell'ordine delle chiavi, dei valori con chiave compresa
+                    nell'intervallo [lo, hi); l'elemento neutro se l'intervallo è vuoto.
+                    Usa gli aggregati dei sottoalberi interamente compresi nell'intervallo, quindi combina
+                    O(maxdepth(tree)) valori.
+    */
 
-}
+    struct node *split, *node;
+    void *left, *right;
 
-struct generator* depth_postorder_iter(struct binstree *tree){
+    assert(tree != NULL && tree->combine != NULL);
 
-    assert(tree != NULL);
+    if (lo >= hi) return tree->identity;
 
-    struct node* temp = tree->radix;
-    struct pile *pile = newpile(), *support;
-    struct generator *gen = smalloc(sizeof(struct generator));
+    // Primo nodo, scendendo dalla radice, la cui chiave cade nell'intervallo
+    for (split = tree->radix; split != NULL && (split->key < lo || split->key >= hi);)
 
-    push((support = newpile()), temp);
+        split = split->key < lo ? split->dx : split->sx;
 
-    while(!isPileEmpty(support)){
+    if (split == NULL) return tree->identity;
 
-        push(pile, (temp = pop(support)));
+    // Nel sottoalbero sinistro ogni nodo con chiave >= lo porta con sè il suo sottoalbero destro;
+    // scendendo si raccolgono parti che precedono quelle già raccolte
+    for (left = tree->identity, node = split->sx; node != NULL;){
 
-        if (temp->dx != NULL) push(support, temp->dx);
+        if (node->key >= lo){
 
-        if (temp->sx != NULL) push(support, temp->sx);
+            left = tree->combine(tree->combine(node->value, aggregateOf(tree, node->dx)), left);
 
-    }
+            node = node->sx;
 
-    destroyPile(support);
-       
-    gen->pila = pile;
-    gen->current_node=pop(pile);
-    gen->visit=DEPTH_POSTORDER_VISIT;
+        }
 
-    return gen;
+        else node = node->dx;
 
-}
+    }
 
-struct generator* breadth_first_iter(struct binstree *tree){
+    // Simmetricamente nel sottoalbero destro ogni nodo con chiave < hi porta con sè il suo sottoalbero sinistro
+    for (right = tree->identity, node = split->dx; node != NULL;){
 
-    struct code *code;
-    struct node *temp;
-    struct generator *gen;
+        if (node->key < hi){
 
-    assert(tree != NULL);
+            right = tree->combine(right, tree->combine(aggregateOf(tree, node->sx), node->value));
 
-    if ((temp = tree->radix) != NULL){
-        
-        code = newcode();
+            node = node->dx;
 
-        if (temp->sx != NULL) enqueue(code, temp->sx);
+        }
 
-        if (temp->dx != NULL) enqueue(code, temp->dx);
+        else node = node->sx;
 
     }
 
-    *(gen = smalloc(sizeof(struct generator))) = (struct generator){
-        .code=code, 
-        .visit=BREADTH_FIRST_VISIT, 
-        .current_node=temp
-    };
-
-    return gen;
+    return tree->combine(tree->combine(left, split->value), right);
 
 }
 
@@ -954,116 +2373,312 @@ void destroyGenerator(struct generator *gen){
 
 }
 
-unsigned int* keys(struct binstree *tree, int visit){
+// Scrive chiave e valore del nodo alla posizione pos dei buffer richiesti
+static inline void exportNode(struct exportarg *args, struct node *node, unsigned int pos){
 
-    struct generator *gen;
-    unsigned int *keys;
-    unsigned int i=0;
+    if (args->keys != NULL) args->keys[pos] = node->key;
 
-    assert(tree != NULL);
+    if (args->values != NULL) args->values[pos] = node->value;
 
-    switch(visit){
+    if (args->items != NULL) args->items[pos] = (struct pair) { .key=node->key, .value=node->value };
 
-        case BREADTH_FIRST_VISIT:
-            gen = breadth_first_iter(tree);
-            break;
+}
 
-        case DEPTH_POSTORDER_VISIT:
-            gen = depth_postorder_iter(tree);
-            break;
+// Esporta il sottoalbero di args->node con un cursore: nelle visite in profondità i nodi di un sottoalbero
+// sono consecutivi, quindi bastano size passi a partire dal primo nodo del sottoalbero
+static void exportSequential(struct exportarg *args){
+
+    struct cursor cursor = {
+        .visit=args->visit, .root=args->node, .depth=0, .bounded=FALSE
+    };
+    unsigned int n = args->node->size;
+
+    switch (args->visit){
 
         case DEPTH_PREORDER_VISIT:
-            gen = depth_preorder_iter(tree);
+            cursor.node = args->node;
             break;
 
-            default:
-                gen = depth_inorder_iter(tree);
+        case DEPTH_POSTORDER_VISIT:
+            cursor.node = deepestFirst(args->node);
+            break;
+
+        default:
+            cursor.node = leftmost(args->node);
 
     }
 
-    keys = smalloc(sizeof(int) * tree->nnodes);
+    for (unsigned int i=0; i<n; i++){
 
-    do{ keys[i++] = genCurr(gen)->key; } while(genNext(gen) != NULL);
+        exportNode(args, cursor.node, args->base + i);
 
-    return keys;
+        cursorNext(&cursor, NULL, NULL);
+
+    }
 
 }
 
-void* values(struct binstree *tree, int visit){
+static void* exportWorker(void *arg);
 
-    struct generator *gen;
-    void **values;
-    unsigned int i=0;
+// Come exportSequential, ma finchè ha thread a disposizione e il sottoalbero è abbastanza grande esporta
+// il sottoalbero sinistro in un nuovo thread: grazie alle dimensioni dei sottoalberi la posizione di ogni
+// parte nei buffer è nota senza visitarla
+static void exportParallelNode(struct exportarg *args){
 
-    assert(tree != NULL);
+    struct exportarg left, right;
+    struct node *node = args->node;
+    unsigned int nsx = subtreeSize(node->sx), pos;
+    pthread_t thread;
+    int spawned;
 
-    switch(visit){
+    if (args->threads < 2 || node->size < PARALLEL_THRESHOLD){
 
-        case BREADTH_FIRST_VISIT:
-            gen = breadth_first_iter(tree);
+        exportSequential(args);
+
+        return;
+
+    }
+
+    left = right = *args;
+    left.node = node->sx, right.node = node->dx;
+    left.threads = args->threads / 2, right.threads = args->threads - args->threads / 2;
+
+    switch (args->visit){
+
+        case DEPTH_PREORDER_VISIT:
+            pos = args->base;
+            left.base = args->base + 1;
+            right.base = left.base + nsx;
             break;
 
         case DEPTH_POSTORDER_VISIT:
-            gen = depth_postorder_iter(tree);
+            pos = args->base + node->size - 1;
+            right.base = args->base + nsx;
             break;
 
-        case DEPTH_PREORDER_VISIT:
-            gen = depth_preorder_iter(tree);
-            break;
+        default:
+            pos = args->base + nsx;
+            right.base = pos + 1;
+
+    }
+
+    exportNode(args, node, pos);
+
+    spawned = FALSE;
+
+    // Se la creazione del thread fallisce il sottoalbero sinistro viene esportato dal thread corrente
+    if (left.node != NULL && (spawned = pthread_create(&thread, NULL, exportWorker, &left) == 0) == FALSE) exportWorker(&left);
+
+    if (right.node != NULL) exportParallelNode(&right);
+
+    if (spawned) pthread_join(thread, NULL);
+
+}
+
+static void* exportWorker(void *arg){
+
+    exportParallelNode(arg);
+
+    return NULL;
+
+}
+
+void exportParallel(struct binstree *tree, int visit, unsigned int *keys, void **values, struct pair *items, unsigned int threads){
+
+    /*
+        Richiede: struttura dati albero binario non nulla, buffer keys, values e items ciascuno NULL oppure
+                    con spazio per nnodes(tree) elementi, numero di thread positivo
+        Effetto: scrive chiavi, valori e coppie chiave-valore dell'albero, nell'ordine del tipo di visita
+                    richiesto (lo stesso dei cursori), nei buffer non NULL, senza allocare memoria per i nodi.
+                    Nelle visite in profondità i sottoalberi con almeno PARALLEL_THRESHOLD nodi vengono
+                    suddivisi tra al più threads thread: la dimensione di ciascun sottoalbero individua la
+                    porzione dei buffer che gli spetta. BREADTH_FIRST_VISIT viene esportata da un solo thread.
+    */
+
+    struct exportarg args = {
+        .node=tree->radix, .visit=visit, .base=0, .threads=threads,
+        .keys=keys, .values=values, .items=items
+    };
+    struct cursor cursor;
+    struct node *node;
+    unsigned int i;
+
+    assert(tree != NULL && threads > 0);
+
+    if (tree->radix == NULL) return;
+
+    if (visit != BREADTH_FIRST_VISIT){
 
-            default:
-                gen = depth_inorder_iter(tree);
+        if (visit != DEPTH_PREORDER_VISIT && visit != DEPTH_POSTORDER_VISIT) args.visit = DEPTH_INORDER_VISIT;
+
+        exportParallelNode(&args);
+
+        return;
 
     }
 
-    values = smalloc(sizeof(void*) * tree->nnodes);
+    cursorInit(&cursor, tree, BREADTH_FIRST_VISIT);
 
-    do{ values[i++] = genCurr(gen)->value; } while(genNext(gen) != NULL);
+    for (i = 0; (node = cursor.node) != NULL; i++){
 
-    return values;
+        exportNode(&args, node, i);
+
+        cursorNext(&cursor, NULL, NULL);
+
+    }
 
 }
 
-struct pair** items(struct binstree *tree, int visit){
+void keysInto(struct binstree *tree, int visit, unsigned int *keys){
 
-    struct generator *gen;
-    struct pair **items;
-    struct pair *temp;
-    unsigned int i=0;
+    /*
+        Richiede: struttura dati albero binario non nulla, buffer con spazio per nnodes(tree) chiavi
+        Effetto: scrive nel buffer le chiavi dell'albero nell'ordine del tipo di visita richiesto,
+                    senza allocare memoria
+    */
 
-    assert(tree != NULL);
+    exportParallel(tree, visit, keys, NULL, NULL, 1);
+
+}
+
+void valuesInto(struct binstree *tree, int visit, void **values){
+
+    /*
+        Richiede: struttura dati albero binario non nulla, buffer con spazio per nnodes(tree) valori
+        Effetto: come keysInto per i valori
+    */
+
+    exportParallel(tree, visit, NULL, values, NULL, 1);
+
+}
+
+void itemsInto(struct binstree *tree, int visit, struct pair *items){
+
+    /*
+        Richiede: struttura dati albero binario non nulla, buffer con spazio per nnodes(tree) coppie
+        Effetto: come keysInto per le coppie chiave-valore
+    */
 
-    switch(visit){
+    exportParallel(tree, visit, NULL, NULL, items, 1);
+
+}
+
+// Esporta l'albero nell'ordine dei generatori, su cui si basano keys, values e items: preordine e visita
+// in ordine coincidono con i cursori, il postordine dei generatori visita il sottoalbero destro prima del
+// sinistro (è il preordine al contrario) e la visita in ampiezza accoda i figli della radice da sinistra
+// e quelli degli altri nodi da destra
+static void generatorExport(struct binstree *tree, int visit, unsigned int *keys, void **values, struct pair *items){
+
+    struct exportarg args = { .keys=keys, .values=values, .items=items };
+    struct node **queue, *node, *first, *second;
+    struct cursor cursor;
+    unsigned int head, tail, n;
+
+    if (tree->radix == NULL) return;
+
+    n = tree->radix->size;
+
+    switch (visit){
 
         case BREADTH_FIRST_VISIT:
-            gen = breadth_first_iter(tree);
+
+            // Il buffer dei nodi fa da coda: ogni nodo viene accodato una sola volta
+            (queue = smalloc(sizeof(struct node*) * n))[0] = tree->radix;
+
+            for (head = 0, tail = 1; head < tail; head++){
+
+                exportNode(&args, (node = queue[head]), head);
+
+                first = head == 0 ? node->sx : node->dx;
+                second = head == 0 ? node->dx : node->sx;
+
+                if (first != NULL) queue[tail++] = first;
+
+                if (second != NULL) queue[tail++] = second;
+
+            }
+
+            free(queue);
+
             break;
 
         case DEPTH_POSTORDER_VISIT:
-            gen = depth_postorder_iter(tree);
-            break;
 
-        case DEPTH_PREORDER_VISIT:
-            gen = depth_preorder_iter(tree);
+            cursorInit(&cursor, tree, DEPTH_PREORDER_VISIT);
+
+            for (head = 0; head < n; head++){
+
+                exportNode(&args, cursor.node, n - 1 - head);
+
+                cursorNext(&cursor, NULL, NULL);
+
+            }
+
             break;
 
-            default:
-                gen = depth_inorder_iter(tree);
+        default:
+            exportParallel(tree, visit, keys, values, items, 1);
 
     }
 
+}
+
+unsigned int* keys(struct binstree *tree, int visit){
+
+    /*
+        Richiede: struttura dati albero binario non nulla
+        Effetto: restituisce un array, da liberare con free, con le chiavi dell'albero nell'ordine
+                    del generatore del tipo di visita richiesto
+    */
+
+    unsigned int *keys;
+
+    assert(tree != NULL);
+
+    generatorExport(tree, visit, (keys = smalloc(sizeof(unsigned int) * tree->nnodes)), NULL, NULL);
+
+    return keys;
+
+}
+
+void* values(struct binstree *tree, int visit){
+
+    /*
+        Richiede: struttura dati albero binario non nulla
+        Effetto: come keys per i valori
+    */
+
+    void **values;
+
+    assert(tree != NULL);
+
+    generatorExport(tree, visit, NULL, (values = smalloc(sizeof(void*) * tree->nnodes)), NULL);
+
+    return values;
+
+}
+
+struct pair** items(struct binstree *tree, int visit){
+
+    /*
+        Richiede: struttura dati albero binario non nulla
+        Effetto: restituisce un array di puntatori alle coppie chiave-valore dell'albero nell'ordine
+                    del generatore del tipo di visita richiesto; ogni coppia è allocata singolarmente e
+                    va liberata con free, come l'array stesso
+    */
+
+    struct pair **items, *pairs;
+    unsigned int i;
+
+    assert(tree != NULL);
+
     items = smalloc(sizeof(struct pair*) * tree->nnodes);
 
-    do{ 
-        
-        *(temp = smalloc(sizeof(struct pair))) = (struct pair){
-            .key = genCurr(gen)->key,
-            .value = genCurr(gen)->value
-        };
-        
-        items[i++] = temp; 
-        
-    } while(genNext(gen) != NULL);
+    generatorExport(tree, visit, NULL, NULL, (pairs = smalloc(sizeof(struct pair) * tree->nnodes)));
+
+    for (i=0; i<tree->nnodes; i++) *(items[i] = smalloc(sizeof(struct pair))) = pairs[i];
+
+    free(pairs);
 
     return items;
 
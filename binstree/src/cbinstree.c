@@ -0,0 +1,656 @@
+#include "../../epoch/header/epoch.h"  // Require use of epoch reclamation (you can find it inside repo)
+#include "../header/cbinstree.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <assert.h>
+
+#define TRUE 1
+#define FALSE 0
+
+// Numero massimo di livelli: con probabilità 1/4 di salire di livello bastano per 4^16 chiavi
+#define MAX_LEVEL 16
+
+
+/*
+    Mappa ordinata condivisibile tra più thread, realizzata come skip list "pigra": ogni nodo ha un lock
+    acquisito solo dalle scritture, che prima di modificare i collegamenti verificano che i predecessori
+    osservati senza lock siano ancora validi. Una rimozione marca il nodo (rimozione logica) e solo dopo
+    lo scollega da tutti i livelli; un inserimento pubblica il nodo livello per livello e lo dichiara
+    completo alla fine. Le letture non acquisiscono alcun lock e non vengono mai ripetute a causa delle
+    scritture: un nodo scollegato mantiene i propri puntatori ai successivi, e viene liberato tramite
+    le epoche solo quando nessun lettore può più raggiungerlo.
+*/
+
+struct cnode {
+
+    unsigned int key;
+
+    // Numero di livelli in cui compare il nodo
+    unsigned int levels;
+
+    void *_Atomic value;
+
+    // Vero dopo la rimozione logica del nodo
+    _Atomic int marked;
+
+    // Vero quando il nodo è stato collegato a tutti i suoi livelli
+    _Atomic int linked;
+
+    pthread_mutex_t lock;
+
+    // Successori sui livelli 0 .. levels-1 (il livello 0 contiene tutti i nodi in ordine di chiave)
+    struct cnode *_Atomic next[];
+
+};
+
+typedef struct cbinstree {
+
+    // Nodo sentinella presente su tutti i livelli, precede qualsiasi chiave
+    struct cnode *head;
+
+    _Atomic unsigned int nnodes;
+
+} *ConcurrentBstree;
+
+
+// Stato del generatore pseudocasuale dei livelli, uno per thread
+static _Thread_local uint32_t seed = 0;
+
+
+// Define static safe malloc that prevents from memory allocations error
+static void* smalloc(unsigned int size){
+
+    void* object = malloc(size);
+
+    if (object == NULL) {
+
+        fprintf(stderr, "Memory allocation error\n");
+
+        exit(0);
+
+    }
+
+    return object;
+
+}
+
+static struct cnode* newNode(unsigned int key, void *value, unsigned int levels){
+
+    struct cnode *node = smalloc(sizeof(struct cnode) + levels * sizeof(struct cnode*));
+
+    node->key = key;
+    node->levels = levels;
+
+    atomic_init(&(node->value), value);
+    atomic_init(&(node->marked), FALSE);
+    atomic_init(&(node->linked), FALSE);
+
+    pthread_mutex_init(&(node->lock), NULL);
+
+    for (unsigned int i=0; i<levels; i++) atomic_init(&(node->next[i]), NULL);
+
+    return node;
+
+}
+
+static void destroyNode(void *node){
+
+    pthread_mutex_destroy(&(((struct cnode*) node)->lock));
+
+    free(node);
+
+}
+
+// Estrae il numero di livelli di un nuovo nodo: ciascun livello successivo con probabilità 1/4 (xorshift32)
+static unsigned int randomLevels(){
+
+    unsigned int levels = 1;
+
+    if (seed == 0) seed = (uint32_t) (uintptr_t) &seed | 1;
+
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    for (uint32_t bits = seed; levels < MAX_LEVEL && (bits & 3) == 0; bits >>= 2) levels++;
+
+    return levels;
+
+}
+
+static inline struct cnode* nextOf(struct cnode *node, unsigned int level){
+
+    return atomic_load_explicit(&(node->next[level]), memory_order_acquire);
+
+}
+
+// Il nodo rappresenta una chiave presente: collegato completamente e non ancora rimosso
+static inline int present(struct cnode *node){
+
+    return atomic_load_explicit(&(node->linked), memory_order_acquire) && !atomic_load_explicit(&(node->marked), memory_order_acquire);
+
+}
+
+// Registra su ogni livello l'ultimo nodo con chiave < key e il suo successore, senza lock.
+// Restituisce il livello più alto in cui compare un nodo con la chiave cercata, -1 se nessuno.
+// Deve essere chiamata all'interno di una sezione critica epochEnter/epochExit
+static int find(struct cbinstree *tree, unsigned int key, struct cnode **preds, struct cnode **succs){
+
+    struct cnode *pred = tree->head, *curr;
+    int found = -1;
+
+    for (int level = MAX_LEVEL - 1; level >= 0; level--){
+
+        for (curr = nextOf(pred, level); curr != NULL && curr->key < key; curr = nextOf(pred, level)) pred = curr;
+
+        if (found < 0 && curr != NULL && curr->key == key) found = level;
+
+        preds[level] = pred;
+        succs[level] = curr;
+
+    }
+
+    return found;
+
+}
+
+// Primo nodo con chiave >= key sul livello 0 (NULL se nessuno), senza lock né registrazione dei predecessori
+static struct cnode* lowerBound(struct cbinstree *tree, unsigned int key){
+
+    struct cnode *pred = tree->head, *curr = NULL;
+
+    for (int level = MAX_LEVEL - 1; level >= 0; level--)
+
+        for (curr = nextOf(pred, level); curr != NULL && curr->key < key; curr = nextOf(pred, level)) pred = curr;
+
+    return curr;
+
+}
+
+// Ultimo nodo presente con chiave < key (con qualsiasi chiave se unbounded), NULL se nessuno.
+// Se il nodo trovato è in corso di inserimento o di rimozione la discesa viene ripetuta
+static struct cnode* lastBefore(struct cbinstree *tree, unsigned int key, int unbounded){
+
+    struct cnode *pred, *curr;
+
+    for (;;){
+
+        pred = tree->head;
+
+        for (int level = MAX_LEVEL - 1; level >= 0; level--)
+
+            for (curr = nextOf(pred, level); curr != NULL && (unbounded || curr->key < key); curr = nextOf(pred, level)) pred = curr;
+
+        if (pred == tree->head) return NULL;
+
+        if (present(pred)) return pred;
+
+    }
+
+}
+
+// Acquisisce i lock dei predecessori dai livelli 0 a levels-1 (ossia per chiavi decrescenti, come ogni altra
+// scrittura, così da evitare stalli) e verifica che siano ancora collegati ai successori attesi.
+// Restituisce il numero di livelli bloccati in *locked, da passare a unlockPreds
+static int lockPreds(struct cnode **preds, struct cnode **succs, unsigned int key, unsigned int levels, unsigned int *locked){
+
+    struct cnode *pred, *succ, *prev = NULL;
+    int valid = TRUE;
+    unsigned int level;
+
+    for (level = 0; valid && level < levels; level++){
+
+        pred = preds[level], succ = succs[level];
+
+        // Lo stesso nodo può precedere su più livelli consecutivi: viene bloccato una sola volta
+        if (pred != prev) pthread_mutex_lock(&(pred->lock));
+
+        prev = pred;
+
+        // Il successore può essere marcato solo se è il nodo che il chiamante sta rimuovendo
+        valid = !atomic_load_explicit(&(pred->marked), memory_order_relaxed) &&
+                (succ == NULL || succ->key == key || !atomic_load_explicit(&(succ->marked), memory_order_relaxed)) &&
+                atomic_load_explicit(&(pred->next[level]), memory_order_relaxed) == succ;
+
+    }
+
+    *locked = level;
+
+    return valid;
+
+}
+
+static void unlockPreds(struct cnode **preds, unsigned int locked){
+
+    struct cnode *prev = NULL;
+
+    for (unsigned int level = 0; level < locked; level++){
+
+        if (preds[level] != prev) pthread_mutex_unlock(&(preds[level]->lock));
+
+        prev = preds[level];
+
+    }
+
+}
+
+struct cbinstree* newConcurrentTree(){
+
+    /*
+        Effetto: crea una mappa ordinata vuota, con le operazioni di binstree.h, condivisibile tra più thread
+                    senza sincronizzazione esterna. Ricerche e visite non acquisiscono lock e non bloccano
+                    le scritture; inserimenti e rimozioni bloccano soltanto i nodi adiacenti alla chiave.
+                    A differenza di binstree ogni chiave compare al più una volta.
+                    La memoria dei nodi rimossi viene recuperata tramite le epoche (epoch.h).
+    */
+
+    struct cbinstree *tree = smalloc(sizeof(struct cbinstree));
+
+    tree->head = newNode(0, NULL, MAX_LEVEL);
+
+    atomic_store(&(tree->head->linked), TRUE);
+    atomic_init(&(tree->nnodes), 0);
+
+    return tree;
+
+}
+
+void* concurrentAppend(struct cbinstree *tree, unsigned int key, void *value){
+
+    /*
+        Richiede: struttura dati albero non nulla
+        Effetto: se la chiave è già presente sostituisce il valore associato e restituisce quello precedente,
+                    altrimenti inserisce la coppia chiave-valore e restituisce NULL.
+                    Attenzione: il valore precedente può essere ancora in uso da parte di lettori concorrenti.
+    */
+
+    struct cnode *preds[MAX_LEVEL], *succs[MAX_LEVEL], *node;
+    unsigned int levels, locked;
+    void *previous;
+    int found;
+
+    assert(tree != NULL);
+
+    levels = randomLevels();
+
+    epochEnter();
+
+    for (;;){
+
+        if ((found = find(tree, key, preds, succs)) >= 0){
+
+            node = succs[found];
+
+            // Un nodo trovato mentre un altro thread lo sta inserendo non è ancora presente: prima di sostituirne
+            // il valore si attende che l'inserimento sia completo, altrimenti una rimozione intermedia andrebbe persa
+            while (!atomic_load_explicit(&(node->linked), memory_order_acquire)) sched_yield();
+
+            // Con il lock del nodo una rimozione concorrente non può intervenire tra la verifica e la sostituzione
+            pthread_mutex_lock(&(node->lock));
+
+            if (!atomic_load_explicit(&(node->marked), memory_order_relaxed)){
+
+                previous = atomic_exchange_explicit(&(node->value), value, memory_order_acq_rel);
+
+                pthread_mutex_unlock(&(node->lock));
+
+                epochExit();
+
+                return previous;
+
+            }
+
+            // Il nodo è in corso di rimozione: si attende che venga scollegato e si ripete
+            pthread_mutex_unlock(&(node->lock));
+
+            continue;
+
+        }
+
+        if (!lockPreds(preds, succs, key, levels, &locked)){
+
+            unlockPreds(preds, locked);
+
+            continue;
+
+        }
+
+        node = newNode(key, value, levels);
+
+        for (unsigned int level = 0; level < levels; level++) atomic_init(&(node->next[level]), succs[level]);
+
+        // Il nodo viene pubblicato dal basso verso l'alto solo dopo essere stato inizializzato completamente
+        for (unsigned int level = 0; level < levels; level++)
+
+            atomic_store_explicit(&(preds[level]->next[level]), node, memory_order_release);
+
+        atomic_store_explicit(&(node->linked), TRUE, memory_order_release);
+
+        unlockPreds(preds, locked);
+
+        atomic_fetch_add_explicit(&(tree->nnodes), 1, memory_order_relaxed);
+
+        epochExit();
+
+        return NULL;
+
+    }
+
+}
+
+void* concurrentSearch(struct cbinstree *tree, unsigned int key){
+
+    /*
+        Richiede: struttura dati albero non nulla
+        Effetto: restituisce il valore associato alla chiave oppure NULL, senza acquisire lock
+    */
+
+    struct cnode *node;
+    void *value = NULL;
+
+    assert(tree != NULL);
+
+    epochEnter();
+
+    if ((node = lowerBound(tree, key)) != NULL && node->key == key && present(node))
+
+        value = atomic_load_explicit(&(node->value), memory_order_acquire);
+
+    epochExit();
+
+    return value;
+
+}
+
+int concurrentIsin(struct cbinstree *tree, unsigned int key){
+
+    /*
+        Richiede: struttura dati albero non nulla
+        Effetto: restituisce True se la chiave è presente, senza acquisire lock
+    */
+
+    struct cnode *node;
+    int found;
+
+    assert(tree != NULL);
+
+    epochEnter();
+
+    found = (node = lowerBound(tree, key)) != NULL && node->key == key && present(node) ? TRUE : FALSE;
+
+    epochExit();
+
+    return found;
+
+}
+
+void concurrentDelete(struct cbinstree *tree, unsigned int key){
+
+    /*
+        Richiede: struttura dati albero non nulla
+        Effetto: rimuove la chiave, se presente. Il nodo viene liberato quando nessun lettore
+                    può più raggiungerlo; attenzione che il valore associato non viene liberato.
+    */
+
+    struct cnode *preds[MAX_LEVEL], *succs[MAX_LEVEL], *victim = NULL;
+    unsigned int locked;
+    int found;
+
+    assert(tree != NULL);
+
+    epochEnter();
+
+    for (;;){
+
+        found = find(tree, key, preds, succs);
+
+        if (victim == NULL){
+
+            // Si rimuove solo un nodo completamente collegato, trovato al suo livello più alto
+            // (altrimenti i predecessori registrati non coprirebbero tutti i suoi livelli)
+            if (found < 0 || !present(succs[found]) || succs[found]->levels != (unsigned int) found + 1){
+
+                epochExit();
+
+                return;
+
+            }
+
+            victim = succs[found];
+
+            pthread_mutex_lock(&(victim->lock));
+
+            // Un'altra rimozione ha già marcato il nodo
+            if (atomic_load_explicit(&(victim->marked), memory_order_relaxed)){
+
+                pthread_mutex_unlock(&(victim->lock));
+
+                epochExit();
+
+                return;
+
+            }
+
+            // Rimozione logica: da qui in poi la chiave risulta assente per tutti i thread
+            atomic_store_explicit(&(victim->marked), TRUE, memory_order_release);
+
+        }
+
+        // Su ogni livello del nodo marcato il predecessore deve puntare ancora al nodo stesso
+        for (unsigned int level = 0; level < victim->levels; level++) succs[level] = victim;
+
+        if (!lockPreds(preds, succs, key, victim->levels, &locked)){
+
+            unlockPreds(preds, locked);
+
+            continue;
+
+        }
+
+        // Scollega il nodo dall'alto verso il basso; i suoi puntatori ai successori restano intatti
+        for (int level = victim->levels - 1; level >= 0; level--)
+
+            atomic_store_explicit(&(preds[level]->next[level]), atomic_load_explicit(&(victim->next[level]), memory_order_relaxed), memory_order_release);
+
+        pthread_mutex_unlock(&(victim->lock));
+
+        unlockPreds(preds, locked);
+
+        atomic_fetch_sub_explicit(&(tree->nnodes), 1, memory_order_relaxed);
+
+        epochExit();
+
+        epochRetire(victim, destroyNode);
+
+        return;
+
+    }
+
+}
+
+unsigned int concurrentNnodes(struct cbinstree *tree){
+
+    /*
+        Richiede: struttura dati albero non nulla
+        Effetto: restituisce il numero di chiavi presenti; con scritture concorrenti in corso il valore è indicativo
+    */
+
+    assert(tree != NULL);
+
+    return atomic_load_explicit(&(tree->nnodes), memory_order_relaxed);
+
+}
+
+int concurrentMin(struct cbinstree *tree, unsigned int *key, void **value){
+
+    /*
+        Richiede: struttura dati albero non nulla
+        Effetto: se la mappa non è vuota scrive in key e value (se non NULL) la chiave minima
+                    e il valore associato e restituisce True, altrimenti restituisce False
+    */
+
+    struct cnode *node;
+
+    assert(tree != NULL);
+
+    epochEnter();
+
+    for (node = nextOf(tree->head, 0); node != NULL && !present(node); node = nextOf(node, 0));
+
+    if (node != NULL){
+
+        if (key != NULL) *key = node->key;
+        if (value != NULL) *value = atomic_load_explicit(&(node->value), memory_order_acquire);
+
+    }
+
+    epochExit();
+
+    return node != NULL ? TRUE : FALSE;
+
+}
+
+int concurrentMax(struct cbinstree *tree, unsigned int *key, void **value){
+
+    /*
+        Richiede: struttura dati albero non nulla
+        Effetto: come concurrentMin per la chiave massima
+    */
+
+    struct cnode *node;
+
+    assert(tree != NULL);
+
+    epochEnter();
+
+    if ((node = lastBefore(tree, 0, TRUE)) != NULL){
+
+        if (key != NULL) *key = node->key;
+        if (value != NULL) *value = atomic_load_explicit(&(node->value), memory_order_acquire);
+
+    }
+
+    epochExit();
+
+    return node != NULL ? TRUE : FALSE;
+
+}
+
+int concurrentPred(struct cbinstree *tree, unsigned int key, unsigned int *pkey, void **pvalue){
+
+    /*
+        Richiede: struttura dati albero non nulla
+        Effetto: se esiste una chiave minore di key scrive in pkey e pvalue (se non NULL) la maggiore
+                    di esse e il valore associato e restituisce True, altrimenti restituisce False
+    */
+
+    struct cnode *node;
+
+    assert(tree != NULL);
+
+    epochEnter();
+
+    if ((node = lastBefore(tree, key, FALSE)) != NULL){
+
+        if (pkey != NULL) *pkey = node->key;
+        if (pvalue != NULL) *pvalue = atomic_load_explicit(&(node->value), memory_order_acquire);
+
+    }
+
+    epochExit();
+
+    return node != NULL ? TRUE : FALSE;
+
+}
+
+void concurrentSeek(struct ccursor *cursor, struct cbinstree *tree, unsigned int key){
+
+    /*
+        Richiede: cursore e albero non nulli, chiamata all'interno di una sezione critica epochEnter/epochExit
+                    aperta dal chiamante, che deve restare aperta fino all'ultima concurrentNext sul cursore
+        Effetto: posiziona il cursore sulla prima chiave >= key; le successive chiamate a concurrentNext
+                    restituiscono le chiavi in ordine crescente fino alla massima.
+                    La visita non acquisisce lock: ogni chiave presente per tutta la sua durata viene
+                    restituita, le chiavi inserite o rimosse nel frattempo possono comparire o meno.
+    */
+
+    assert(cursor != NULL && tree != NULL);
+
+    cursor->node = lowerBound(tree, key);
+    cursor->bounded = FALSE;
+
+}
+
+void concurrentRangeIter(struct ccursor *cursor, struct cbinstree *tree, unsigned int lo, unsigned int hi){
+
+    /*
+        Richiede: come concurrentSeek
+        Effetto: come concurrentSeek(cursor, tree, lo), ma la visita termina alla prima chiave >= hi
+    */
+
+    concurrentSeek(cursor, tree, lo);
+
+    cursor->bounded = TRUE;
+    cursor->hi = hi;
+
+}
+
+int concurrentNext(struct ccursor *cursor, unsigned int *key, void **value){
+
+    /*
+        Richiede: cursore inizializzato, nella stessa sezione critica della sua inizializzazione
+        Effetto: se la visita non è terminata scrive in key e value (se non NULL) la prossima chiave
+                    e il valore associato e restituisce True, altrimenti restituisce False
+    */
+
+    struct cnode *node;
+
+    assert(cursor != NULL);
+
+    // Salta i nodi non ancora collegati o già rimossi, che continuano a puntare ai propri successori
+    for (node = cursor->node; node != NULL && !present(node); node = nextOf(node, 0));
+
+    if (node == NULL || (cursor->bounded && node->key >= cursor->hi)){
+
+        cursor->node = NULL;
+
+        return FALSE;
+
+    }
+
+    if (key != NULL) *key = node->key;
+    if (value != NULL) *value = atomic_load_explicit(&(node->value), memory_order_acquire);
+
+    cursor->node = nextOf(node, 0);
+
+    return TRUE;
+
+}
+
+void destroyConcurrentTree(struct cbinstree *tree){
+
+    /*
+        Richiede: struttura dati albero non nulla, nessuna operazione concorrente in corso
+        Effetto: libera i nodi e la struttura dell'albero. I nodi rimossi in precedenza vengono liberati
+                    dal meccanismo delle epoche. Attenzione che non libera lo spazio riservato ai valori.
+    */
+
+    struct cnode *node, *next;
+
+    assert(tree != NULL);
+
+    for (node = tree->head; node != NULL; node = next){
+
+        next = atomic_load(&(node->next[0]));
+
+        destroyNode(node);
+
+    }
+
+    free(tree);
+
+}
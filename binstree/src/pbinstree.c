@@ -0,0 +1,563 @@
+#include "../header/pbinstree.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <assert.h>
+
+#define TRUE 1
+#define FALSE 0
+
+
+/*
+    Albero AVL persistente: i nodi raggiungibili da una snapshot non vengono mai modificati.
+    Ogni aggiornamento copia soltanto i nodi condivisi lungo il cammino dalla radice alla chiave
+    (e quelli coinvolti nelle rotazioni) e condivide con le versioni precedenti tutti gli altri sottoalberi.
+    Un nodo con un solo riferimento appartiene esclusivamente alla versione corrente e viene
+    modificato sul posto, così che senza snapshot aperte gli aggiornamenti non allochino più di
+    un nodo. Ogni nodo conta i riferimenti ricevuti da padri, versione corrente e snapshot:
+    quando l'ultimo viene rilasciato il nodo è liberato e rilascia a sua volta i figli.
+*/
+
+struct pnode {
+
+    struct pnode *sx, *dx;
+
+    unsigned int key;
+
+    int height;
+
+    void *value;
+
+    _Atomic unsigned int refs;
+
+};
+
+typedef struct pbinstree {
+
+    // Serializza le scritture e l'acquisizione delle snapshot
+    pthread_mutex_t lock;
+
+    struct pnode *root;
+
+    unsigned int nnodes;
+
+} *PersistentBstree;
+
+// Versione immutabile dell'albero
+typedef struct psnapshot {
+
+    struct pnode *root;
+
+    unsigned int nnodes;
+
+} *Snapshot;
+
+
+// Define static safe malloc that prevents from memory allocations error
+static void* smalloc(unsigned int size){
+
+    void* object = malloc(size);
+
+    if (object == NULL) {
+
+        fprintf(stderr, "Memory allocation error\n");
+
+        exit(0);
+
+    }
+
+    return object;
+
+}
+
+static inline int height(struct pnode *node){
+
+    return node != NULL ? node->height : 0;
+
+}
+
+static inline void updateHeight(struct pnode *node){
+
+    int hsx = height(node->sx), hdx = height(node->dx);
+
+    node->height = (hsx > hdx ? hsx : hdx) + 1;
+
+}
+
+static inline struct pnode* retain(struct pnode *node){
+
+    if (node != NULL) atomic_fetch_add_explicit(&(node->refs), 1, memory_order_relaxed);
+
+    return node;
+
+}
+
+// Rilascia un riferimento; l'ultimo libera il nodo e rilascia i figli
+static void release(struct pnode *node){
+
+    while (node != NULL && atomic_fetch_sub_explicit(&(node->refs), 1, memory_order_acq_rel) == 1){
+
+        struct pnode *dx = node->dx;
+
+        release(node->sx);
+
+        free(node);
+
+        // Il figlio destro viene rilasciato iterativamente
+        node = dx;
+
+    }
+
+}
+
+static struct pnode* newNode(unsigned int key, void *value){
+
+    struct pnode *node = smalloc(sizeof(struct pnode));
+
+    *node = (struct pnode) { .sx=NULL, .dx=NULL, .key=key, .height=1, .value=value };
+
+    atomic_init(&(node->refs), 1);
+
+    return node;
+
+}
+
+// Restituisce un nodo modificabile al posto di node, consumandone il riferimento: node stesso se è
+// l'unico riferimento, altrimenti una copia che condivide (e trattiene) i figli
+static struct pnode* writable(struct pnode *node){
+
+    struct pnode *copy;
+
+    if (atomic_load_explicit(&(node->refs), memory_order_acquire) == 1) return node;
+
+    copy = newNode(node->key, node->value);
+    copy->sx = retain(node->sx);
+    copy->dx = retain(node->dx);
+    copy->height = node->height;
+
+    release(node);
+
+    return copy;
+
+}
+
+// Rotazioni su un nodo modificabile: il figlio coinvolto viene reso modificabile a sua volta
+static struct pnode* rotateRight(struct pnode *top){
+
+    struct pnode *lchild = (top->sx = writable(top->sx));
+
+    top->sx = lchild->dx;
+    lchild->dx = top;
+
+    updateHeight(top);
+    updateHeight(lchild);
+
+    return lchild;
+
+}
+
+static struct pnode* rotateLeft(struct pnode *top){
+
+    struct pnode *rchild = (top->dx = writable(top->dx));
+
+    top->dx = rchild->sx;
+    rchild->sx = top;
+
+    updateHeight(top);
+    updateHeight(rchild);
+
+    return rchild;
+
+}
+
+// Ripristina la proprietà AVL su un nodo modificabile e restituisce la nuova radice del sottoalbero
+static struct pnode* rebalance(struct pnode *node){
+
+    int factor = height(node->sx) - height(node->dx);
+
+    if (factor > 1){
+
+        // Caso sinistro-destro: il figlio sinistro pende a destra e va prima ruotato a sinistra
+        if (height(node->sx->sx) < height(node->sx->dx)){
+
+            node->sx = writable(node->sx);
+            node->sx = rotateLeft(node->sx);
+
+        }
+
+        return rotateRight(node);
+
+    }
+
+    if (factor < -1){
+
+        if (height(node->dx->dx) < height(node->dx->sx)){
+
+            node->dx = writable(node->dx);
+            node->dx = rotateRight(node->dx);
+
+        }
+
+        return rotateLeft(node);
+
+    }
+
+    updateHeight(node);
+
+    return node;
+
+}
+
+// Inserisce nel sottoalbero consumando il riferimento a node; restituisce un riferimento alla nuova radice
+static struct pnode* insert(struct pnode *node, unsigned int key, void *value){
+
+    if (node == NULL) return newNode(key, value);
+
+    node = writable(node);
+
+    if (node->key > key) node->sx = insert(node->sx, key, value);
+
+    else node->dx = insert(node->dx, key, value);
+
+    return rebalance(node);
+
+}
+
+// Rimuove il nodo minimo del sottoalbero (non vuoto) copiandone chiave e valore in key e value
+static struct pnode* removeMin(struct pnode *node, unsigned int *key, void **value){
+
+    struct pnode *dx;
+
+    if (node->sx == NULL){
+
+        *key = node->key;
+        *value = node->value;
+
+        dx = retain(node->dx);
+
+        release(node);
+
+        return dx;
+
+    }
+
+    node = writable(node);
+
+    node->sx = removeMin(node->sx, key, value);
+
+    return rebalance(node);
+
+}
+
+// Rimuove un nodo con la chiave, che deve essere presente nel sottoalbero
+static struct pnode* removeKey(struct pnode *node, unsigned int key){
+
+    struct pnode *child;
+
+    if (node->key == key){
+
+        // Con due figli il nodo assume chiave e valore del successore, che viene rimosso al suo posto
+        if (node->sx != NULL && node->dx != NULL){
+
+            node = writable(node);
+
+            node->dx = removeMin(node->dx, &(node->key), &(node->value));
+
+            return rebalance(node);
+
+        }
+
+        child = retain(node->sx != NULL ? node->sx : node->dx);
+
+        release(node);
+
+        return child;
+
+    }
+
+    node = writable(node);
+
+    if (node->key > key) node->sx = removeKey(node->sx, key);
+
+    else node->dx = removeKey(node->dx, key);
+
+    return rebalance(node);
+
+}
+
+static struct pnode* find(struct pnode *node, unsigned int key){
+
+    while (node != NULL && node->key != key) node = node->key > key ? node->sx : node->dx;
+
+    return node;
+
+}
+
+struct pbinstree* newPersistentTree(){
+
+    /*
+        Effetto: crea un albero binario di ricerca persistente vuoto, bilanciato come BINSTREE_AVL.
+                    Le scritture (persistentAppend, persistentDelete) possono essere chiamate da più thread
+                    e vengono serializzate; snapshot restituisce in tempo O(1) una versione immutabile
+                    dell'albero, consultabile senza lock mentre le scritture proseguono.
+                    Ogni scrittura copia al più O(log n) nodi condivisi con le snapshot ancora aperte.
+    */
+
+    struct pbinstree *tree = smalloc(sizeof(struct pbinstree));
+
+    pthread_mutex_init(&(tree->lock), NULL);
+
+    tree->root = NULL;
+    tree->nnodes = 0;
+
+    return tree;
+
+}
+
+void persistentAppend(struct pbinstree *tree, unsigned int key, void *value){
+
+    /*
+        Richiede: struttura dati albero non nulla
+        Effetto: inserisce la coppia chiave-valore nella versione corrente dell'albero; come append,
+                    una chiave già presente viene inserita nuovamente. Le snapshot già acquisite non cambiano.
+    */
+
+    assert(tree != NULL);
+
+    pthread_mutex_lock(&(tree->lock));
+
+    tree->root = insert(tree->root, key, value);
+    tree->nnodes++;
+
+    pthread_mutex_unlock(&(tree->lock));
+
+}
+
+void persistentDelete(struct pbinstree *tree, unsigned int key){
+
+    /*
+        Richiede: struttura dati albero non nulla
+        Effetto: rimuove un nodo con la chiave dalla versione corrente dell'albero, se presente.
+                    Le snapshot già acquisite non cambiano.
+    */
+
+    assert(tree != NULL);
+
+    pthread_mutex_lock(&(tree->lock));
+
+    // La ricerca preventiva evita di copiare il cammino quando la chiave è assente
+    if (find(tree->root, key) != NULL){
+
+        tree->root = removeKey(tree->root, key);
+        tree->nnodes--;
+
+    }
+
+    pthread_mutex_unlock(&(tree->lock));
+
+}
+
+unsigned int persistentNnodes(struct pbinstree *tree){
+
+    /*
+        Richiede: albero persistente non nullo
+        Effetto: restituisce il numero di nodi della versione corrente dell'albero
+    */
+
+    unsigned int nnodes;
+
+    assert(tree != NULL);
+
+    pthread_mutex_lock(&(tree->lock));
+
+    nnodes = tree->nnodes;
+
+    pthread_mutex_unlock(&(tree->lock));
+
+    return nnodes;
+
+}
+
+struct psnapshot* snapshot(struct pbinstree *tree){
+
+    /*
+        Richiede: struttura dati albero non nulla
+        Effetto: restituisce in tempo O(1) la versione corrente dell'albero, che non verrà più modificata.
+                    Il lock delle scritture viene trattenuto solo per leggere e trattenere la radice.
+                    La snapshot va rilasciata con destroySnapshot.
+    */
+
+    struct psnapshot *snap = smalloc(sizeof(struct psnapshot));
+
+    assert(tree != NULL);
+
+    pthread_mutex_lock(&(tree->lock));
+
+    snap->root = retain(tree->root);
+    snap->nnodes = tree->nnodes;
+
+    pthread_mutex_unlock(&(tree->lock));
+
+    return snap;
+
+}
+
+void* snapshotSearch(struct psnapshot *snap, unsigned int key){
+
+    /*
+        Richiede: snapshot non nulla
+        Effetto: restituisce il valore associato alla chiave nella snapshot, NULL se assente
+    */
+
+    struct pnode *node;
+
+    assert(snap != NULL);
+
+    return (node = find(snap->root, key)) != NULL ? node->value : NULL;
+
+}
+
+int snapshotIsin(struct psnapshot *snap, unsigned int key){
+
+    /*
+        Richiede: snapshot non nulla
+        Effetto: restituisce True se la chiave è presente nella snapshot, False altrimenti
+    */
+
+    assert(snap != NULL);
+
+    return find(snap->root, key) != NULL ? TRUE : FALSE;
+
+}
+
+unsigned int snapshotNnodes(struct psnapshot *snap){
+
+    /*
+        Richiede: snapshot non nulla
+        Effetto: restituisce il numero di nodi della snapshot, che non cambia con le modifiche successive dell'albero
+    */
+
+    assert(snap != NULL);
+
+    return snap->nnodes;
+
+}
+
+void snapshotSeek(struct pcursor *cursor, struct psnapshot *snap, unsigned int key){
+
+    /*
+        Richiede: cursore e snapshot non nulli
+        Effetto: posiziona il cursore sulla prima chiave >= key della snapshot; le successive chiamate a
+                    snapshotNext restituiscono le chiavi in ordine crescente fino alla massima.
+                    Il cursore resta valido finchè la snapshot non viene rilasciata.
+    */
+
+    struct pnode *node;
+
+    assert(cursor != NULL && snap != NULL);
+
+    cursor->depth = 0;
+    cursor->bounded = FALSE;
+
+    // Restano sulla pila i nodi con chiave >= key incontrati scendendo, il più piccolo in cima
+    for (node = snap->root; node != NULL;){
+
+        if (node->key >= key){
+
+            cursor->stack[cursor->depth++] = node;
+
+            node = node->sx;
+
+        }
+
+        else node = node->dx;
+
+    }
+
+}
+
+void snapshotRangeIter(struct pcursor *cursor, struct psnapshot *snap, unsigned int lo, unsigned int hi){
+
+    /*
+        Richiede: cursore e snapshot non nulli
+        Effetto: come snapshotSeek(cursor, snap, lo), ma la visita termina alla prima chiave >= hi
+    */
+
+    snapshotSeek(cursor, snap, lo);
+
+    cursor->bounded = TRUE;
+    cursor->hi = hi;
+
+}
+
+int snapshotNext(struct pcursor *cursor, unsigned int *key, void **value){
+
+    /*
+        Richiede: cursore inizializzato, snapshot non ancora rilasciata
+        Effetto: se la visita non è terminata scrive in key e value (se non NULL) la prossima chiave
+                    e il valore associato e restituisce True, altrimenti restituisce False
+    */
+
+    struct pnode *node;
+
+    assert(cursor != NULL);
+
+    if (cursor->depth == 0) return FALSE;
+
+    node = cursor->stack[cursor->depth - 1];
+
+    if (cursor->bounded && node->key >= cursor->hi){
+
+        cursor->depth = 0;
+
+        return FALSE;
+
+    }
+
+    if (key != NULL) *key = node->key;
+
+    if (value != NULL) *value = node->value;
+
+    // Il successore è il minimo del sottoalbero destro, oppure l'antenato già sulla pila
+    cursor->depth--;
+
+    for (node = node->dx; node != NULL; node = node->sx) cursor->stack[cursor->depth++] = node;
+
+    return TRUE;
+
+}
+
+void destroySnapshot(struct psnapshot *snap){
+
+    /*
+        Richiede: snapshot non nulla, senza cursori ancora in uso
+        Effetto: rilascia la snapshot; i nodi non più condivisi con altre versioni vengono liberati.
+                    Può essere chiamata da qualsiasi thread, anche durante le scritture sull'albero.
+    */
+
+    assert(snap != NULL);
+
+    release(snap->root);
+
+    free(snap);
+
+}
+
+void destroyPersistentTree(struct pbinstree *tree){
+
+    /*
+        Richiede: struttura dati albero non nulla, nessuna scrittura concorrente in corso
+        Effetto: rilascia la versione corrente e libera l'albero. Le snapshot ancora aperte restano valide
+                    fino alla loro destroySnapshot. Attenzione che non libera lo spazio riservato ai valori.
+    */
+
+    assert(tree != NULL);
+
+    release(tree->root);
+
+    pthread_mutex_destroy(&(tree->lock));
+
+    free(tree);
+
+}
@@ -0,0 +1,52 @@
+#ifndef BPTREE_H
+#define BPTREE_H
+
+typedef struct bptree bptree;
+
+typedef struct bpnode bpnode;
+
+// Cursore per la visita in ordine delle chiavi: va dichiarato dal chiamante (anche sullo stack)
+// e inizializzato con bptreeSeek o bptreeRangeIter. I campi sono riservati alle funzioni bptree*
+typedef struct bpcursor {
+
+    // Foglia e posizione della prossima chiave da restituire (leaf NULL a visita terminata)
+    struct bpnode *leaf;
+
+    unsigned int index;
+
+    // Se bounded è vero la visita termina alla prima chiave >= hi
+    int bounded;
+
+    unsigned int hi;
+
+} *BPCursor;
+
+
+struct bptree* newBPTree();
+
+void bptreeAppend(struct bptree *tree, unsigned int key, void *value);
+
+void* bptreeSearch(struct bptree *tree, unsigned int key);
+
+int bptreeIsin(struct bptree *tree, unsigned int key);
+
+void bptreeDelete(struct bptree *tree, unsigned int key);
+
+unsigned int bptreeCount(struct bptree *tree);
+
+int bptreeMin(struct bptree *tree, unsigned int *key, void **value);
+
+int bptreeMax(struct bptree *tree, unsigned int *key, void **value);
+
+int bptreePred(struct bptree *tree, unsigned int key, unsigned int *pkey, void **pvalue);
+
+void bptreeSeek(struct bpcursor *cursor, struct bptree *tree, unsigned int key);
+
+void bptreeRangeIter(struct bpcursor *cursor, struct bptree *tree, unsigned int lo, unsigned int hi);
+
+int bptreeNext(struct bpcursor *cursor, unsigned int *key, void **value);
+
+void destroyBPTree(struct bptree *tree);
+
+
+#endif
@@ -0,0 +1,695 @@
+#include "../header/bptree.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <assert.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define TRUE 1
+#define FALSE 0
+
+// Numero massimo di chiavi per nodo (multiplo di 4, la larghezza di un confronto SSE2)
+#define BPTREE_KEYS 32
+
+// Numero minimo di chiavi di un nodo diverso dalla radice
+#define BPTREE_MIN (BPTREE_KEYS / 2)
+
+// Valore delle posizioni libere dell'array di chiavi: non è mai minore di una chiave cercata,
+// così che la ricerca possa confrontare sempre l'intero array senza controllare count
+#define PAD UINT32_MAX
+
+
+// Nodo dell'albero. Le chiavi sono contigue all'inizio del nodo (due linee di cache) e vengono confrontate
+// tutte insieme; in un nodo interno il figlio i contiene le chiavi comprese in (keys[i-1], keys[i]]
+typedef struct bpnode {
+
+    _Alignas(64) uint32_t keys[BPTREE_KEYS];
+
+    // Numero di chiavi (di separatori per un nodo interno, che ha count + 1 figli)
+    unsigned int count;
+
+    int leaf;
+
+    union {
+
+        // Nodo interno
+        struct bpnode *children[BPTREE_KEYS + 1];
+
+        // Foglia: valori associati alle chiavi e foglie adiacenti nell'ordine delle chiavi
+        struct {
+
+            void *values[BPTREE_KEYS];
+
+            struct bpnode *prev, *next;
+
+        };
+
+    };
+
+} *BPNode;
+
+typedef struct bptree {
+
+    // La radice è sempre presente: un albero vuoto è formato da una foglia vuota
+    struct bpnode *root;
+
+    unsigned int count;
+
+} *BPTree;
+
+
+// Define static aligned malloc that prevents from memory allocations error
+static struct bpnode* nodeAlloc(int leaf){
+
+    struct bpnode *node = aligned_alloc(_Alignof(struct bpnode), sizeof(struct bpnode));
+
+    if (node == NULL) {
+
+        fprintf(stderr, "Memory allocation error\n");
+
+        exit(0);
+
+    }
+
+    node->count = 0;
+    node->leaf = leaf;
+
+    for (int i=0; i<BPTREE_KEYS; i++) node->keys[i] = PAD;
+
+    if (leaf) node->prev = node->next = NULL;
+
+    return node;
+
+}
+
+// Numero di chiavi del nodo strettamente minori di key, ossia la posizione della prima chiave >= key
+// nella foglia e l'indice del figlio che può contenere key nel nodo interno
+static inline unsigned int countLess(const struct bpnode *node, uint32_t key){
+
+    unsigned int count = 0;
+
+#ifdef __SSE2__
+
+    // SSE2 confronta solo interi con segno: invertire il bit più significativo preserva l'ordine
+    const __m128i bias = _mm_set1_epi32(INT_MIN);
+    const __m128i probe = _mm_xor_si128(_mm_set1_epi32((int) key), bias);
+
+    for (int i=0; i<BPTREE_KEYS; i+=4){
+
+        __m128i keys = _mm_xor_si128(_mm_load_si128((const __m128i*) (node->keys + i)), bias);
+
+        count += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(keys, probe))));
+
+    }
+
+#else
+
+    for (int i=0; i<BPTREE_KEYS; i++) count += node->keys[i] < key;
+
+#endif
+
+    return count;
+
+}
+
+// Scende dalla radice fino alla foglia che contiene (o conterrebbe) la chiave
+static struct bpnode* findLeaf(struct bptree *tree, uint32_t key){
+
+    struct bpnode *node = tree->root;
+
+    while (!node->leaf) node = node->children[countLess(node, key)];
+
+    return node;
+
+}
+
+// Inserisce la coppia nel sottoalbero del nodo. Se il nodo si divide restituisce il nuovo fratello destro
+// e scrive in separator la massima chiave rimasta nel nodo, altrimenti restituisce NULL
+static struct bpnode* insertInto(struct bptree *tree, struct bpnode *node, uint32_t key, void *value, uint32_t *separator){
+
+    uint32_t keys[BPTREE_KEYS + 1];
+    void *items[BPTREE_KEYS + 2];
+    struct bpnode *right, *child;
+    unsigned int pos = countLess(node, key), n = node->count, half, i;
+
+    if (node->leaf){
+
+        // La chiave è già presente: sostituisce il valore
+        if (pos < n && node->keys[pos] == key){
+
+            node->values[pos] = value;
+
+            return NULL;
+
+        }
+
+        tree->count++;
+
+        if (n < BPTREE_KEYS){
+
+            for (i = n; i > pos; i--) node->keys[i] = node->keys[i-1], node->values[i] = node->values[i-1];
+
+            node->keys[pos] = key;
+            node->values[pos] = value;
+            node->count++;
+
+            return NULL;
+
+        }
+
+        // Foglia piena: le BPTREE_KEYS + 1 coppie vengono ripartite tra il nodo e un nuovo fratello destro
+        for (i = 0; i < pos; i++) keys[i] = node->keys[i], items[i] = node->values[i];
+
+        keys[pos] = key, items[pos] = value;
+
+        for (i = pos; i < n; i++) keys[i+1] = node->keys[i], items[i+1] = node->values[i];
+
+        right = nodeAlloc(TRUE);
+        half = (BPTREE_KEYS + 1) / 2;
+
+        for (i = 0; i < BPTREE_KEYS + 1; i++){
+
+            if (i < half) node->keys[i] = keys[i], node->values[i] = items[i];
+
+            else right->keys[i - half] = keys[i], right->values[i - half] = items[i];
+
+        }
+
+        for (i = half; i < BPTREE_KEYS; i++) node->keys[i] = PAD;
+
+        node->count = half;
+        right->count = BPTREE_KEYS + 1 - half;
+
+        if ((right->next = node->next) != NULL) right->next->prev = right;
+
+        right->prev = node;
+        node->next = right;
+
+        *separator = node->keys[half - 1];
+
+        return right;
+
+    }
+
+    if ((child = insertInto(tree, node->children[pos], key, value, separator)) == NULL) return NULL;
+
+    // Il figlio pos si è diviso: il separatore e il nuovo figlio vanno inseriti subito dopo di esso
+    if (n < BPTREE_KEYS){
+
+        for (i = n; i > pos; i--) node->keys[i] = node->keys[i-1], node->children[i+1] = node->children[i];
+
+        node->keys[pos] = *separator;
+        node->children[pos+1] = child;
+        node->count++;
+
+        return NULL;
+
+    }
+
+    // Nodo interno pieno: il separatore centrale sale al padre
+    for (i = 0; i < pos; i++) keys[i] = node->keys[i];
+
+    keys[pos] = *separator;
+
+    for (i = pos; i < n; i++) keys[i+1] = node->keys[i];
+
+    for (i = 0; i <= pos; i++) items[i] = node->children[i];
+
+    items[pos+1] = child;
+
+    for (i = pos + 1; i <= n; i++) items[i+1] = node->children[i];
+
+    right = nodeAlloc(FALSE);
+    half = (BPTREE_KEYS + 1) / 2;
+
+    for (i = 0; i < half; i++) node->keys[i] = keys[i], node->children[i] = items[i];
+
+    node->children[half] = items[half];
+
+    for (i = half; i < BPTREE_KEYS; i++) node->keys[i] = PAD;
+
+    for (i = half + 1; i < BPTREE_KEYS + 1; i++) right->keys[i - half - 1] = keys[i];
+
+    for (i = half + 1; i < BPTREE_KEYS + 2; i++) right->children[i - half - 1] = items[i];
+
+    node->count = half;
+    right->count = BPTREE_KEYS - half;
+
+    *separator = keys[half];
+
+    return right;
+
+}
+
+// Rimuove la chiave e il valore (o il figlio destro del separatore) in posizione pos
+static void removeAt(struct bpnode *node, unsigned int pos){
+
+    unsigned int i;
+
+    for (i = pos; i + 1 < node->count; i++){
+
+        node->keys[i] = node->keys[i+1];
+
+        if (node->leaf) node->values[i] = node->values[i+1];
+
+        else node->children[i+1] = node->children[i+2];
+
+    }
+
+    node->keys[--node->count] = PAD;
+
+}
+
+// Riporta il figlio i, sceso sotto BPTREE_MIN chiavi, al numero minimo prendendo una chiave da un fratello
+// oppure fondendolo con un fratello
+static void fix(struct bpnode *node, unsigned int i){
+
+    struct bpnode *child = node->children[i], *left, *right;
+    unsigned int j;
+
+    left = i > 0 ? node->children[i-1] : NULL;
+    right = i < node->count ? node->children[i+1] : NULL;
+
+    if (left != NULL && left->count > BPTREE_MIN){
+
+        for (j = child->count; j > 0; j--){
+
+            child->keys[j] = child->keys[j-1];
+
+            if (child->leaf) child->values[j] = child->values[j-1];
+
+        }
+
+        if (child->leaf){
+
+            child->keys[0] = left->keys[left->count - 1];
+            child->values[0] = left->values[left->count - 1];
+
+            left->keys[--left->count] = PAD;
+
+            node->keys[i-1] = left->keys[left->count - 1];
+
+        }
+
+        else {
+
+            for (j = child->count + 1; j > 0; j--) child->children[j] = child->children[j-1];
+
+            // Il separatore del padre scende nel figlio e l'ultima chiave del fratello sale al padre
+            child->keys[0] = node->keys[i-1];
+            child->children[0] = left->children[left->count];
+
+            node->keys[i-1] = left->keys[left->count - 1];
+
+            left->keys[--left->count] = PAD;
+
+        }
+
+        child->count++;
+
+    }
+
+    else if (right != NULL && right->count > BPTREE_MIN){
+
+        if (child->leaf){
+
+            child->keys[child->count] = right->keys[0];
+            child->values[child->count] = right->values[0];
+
+            node->keys[i] = right->keys[0];
+
+        }
+
+        else {
+
+            child->keys[child->count] = node->keys[i];
+            child->children[child->count + 1] = right->children[0];
+
+            node->keys[i] = right->keys[0];
+
+            right->children[0] = right->children[1];
+
+        }
+
+        child->count++;
+
+        removeAt(right, 0);
+
+    }
+
+    else {
+
+        // Fonde il figlio con il fratello alla sua destra (o con quello alla sua sinistra se è l'ultimo)
+        if (right == NULL) right = child, child = left, i--;
+
+        if (child->leaf){
+
+            for (j = 0; j < right->count; j++){
+
+                child->keys[child->count + j] = right->keys[j];
+                child->values[child->count + j] = right->values[j];
+
+            }
+
+            if ((child->next = right->next) != NULL) child->next->prev = child;
+
+        }
+
+        else {
+
+            child->keys[child->count++] = node->keys[i];
+
+            for (j = 0; j < right->count; j++) child->keys[child->count + j] = right->keys[j];
+
+            for (j = 0; j <= right->count; j++) child->children[child->count + j] = right->children[j];
+
+        }
+
+        child->count += right->count;
+
+        // Il separatore tra i due figli scompare insieme al puntatore al fratello destro
+        removeAt(node, i);
+
+        free(right);
+
+    }
+
+}
+
+// Rimuove la chiave dal sottoalbero del nodo, restituisce TRUE se era presente
+static int deleteFrom(struct bpnode *node, uint32_t key){
+
+    unsigned int pos = countLess(node, key);
+
+    if (node->leaf){
+
+        if (pos >= node->count || node->keys[pos] != key) return FALSE;
+
+        removeAt(node, pos);
+
+        return TRUE;
+
+    }
+
+    if (!deleteFrom(node->children[pos], key)) return FALSE;
+
+    if (node->children[pos]->count < BPTREE_MIN) fix(node, pos);
+
+    return TRUE;
+
+}
+
+struct bptree* newBPTree(){
+
+    /*
+        Effetto: crea un B+albero vuoto, una mappa ordinata da chiavi unsigned int a valori void*.
+                    Ogni nodo contiene fino a BPTREE_KEYS chiavi contigue confrontate con istruzioni SSE2,
+                    quindi una ricerca visita pochi nodi e poche linee di cache; le foglie sono collegate
+                    tra loro per scorrere gli intervalli di chiavi senza risalire l'albero.
+    */
+
+    struct bptree *tree = malloc(sizeof(struct bptree));
+
+    if (tree == NULL) {
+
+        fprintf(stderr, "Memory allocation error\n");
+
+        exit(0);
+
+    }
+
+    tree->root = nodeAlloc(TRUE);
+    tree->count = 0;
+
+    return tree;
+
+}
+
+void bptreeAppend(struct bptree *tree, unsigned int key, void *value){
+
+    /*
+        Richiede: struttura dati B+albero non nulla
+        Effetto: associa il valore alla chiave. A differenza di binstree le chiavi sono uniche:
+                    se la chiave è già presente il valore precedente viene sostituito.
+    */
+
+    struct bpnode *right, *root;
+    uint32_t separator;
+
+    assert(tree != NULL);
+
+    if ((right = insertInto(tree, tree->root, key, value, &separator)) == NULL) return;
+
+    // La radice si è divisa: l'albero cresce di un livello
+    root = nodeAlloc(FALSE);
+    root->keys[0] = separator;
+    root->children[0] = tree->root;
+    root->children[1] = right;
+    root->count = 1;
+
+    tree->root = root;
+
+}
+
+void* bptreeSearch(struct bptree *tree, unsigned int key){
+
+    /*
+        Richiede: struttura dati B+albero non nulla
+        Effetto: restituisce il valore associato alla chiave, NULL se la chiave non è presente
+    */
+
+    struct bpnode *leaf;
+    unsigned int pos;
+
+    assert(tree != NULL);
+
+    pos = countLess((leaf = findLeaf(tree, key)), key);
+
+    return pos < leaf->count && leaf->keys[pos] == key ? leaf->values[pos] : NULL;
+
+}
+
+int bptreeIsin(struct bptree *tree, unsigned int key){
+
+    struct bpnode *leaf;
+    unsigned int pos;
+
+    assert(tree != NULL);
+
+    pos = countLess((leaf = findLeaf(tree, key)), key);
+
+    return pos < leaf->count && leaf->keys[pos] == key ? TRUE : FALSE;
+
+}
+
+void bptreeDelete(struct bptree *tree, unsigned int key){
+
+    /*
+        Richiede: struttura dati B+albero non nulla
+        Effetto: rimuove la chiave e il valore associato, se presenti
+    */
+
+    struct bpnode *root;
+
+    assert(tree != NULL);
+
+    if (!deleteFrom((root = tree->root), key)) return;
+
+    tree->count--;
+
+    // Una radice interna rimasta con un solo figlio viene sostituita dal figlio
+    if (!root->leaf && root->count == 0){
+
+        tree->root = root->children[0];
+
+        free(root);
+
+    }
+
+}
+
+unsigned int bptreeCount(struct bptree *tree){
+
+    assert(tree != NULL);
+
+    return tree->count;
+
+}
+
+int bptreeMin(struct bptree *tree, unsigned int *key, void **value){
+
+    /*
+        Richiede: struttura dati B+albero non nulla
+        Effetto: scrive in key e value (se non NULL) la chiave minima e il valore associato
+                    e restituisce TRUE; se l'albero è vuoto restituisce FALSE.
+    */
+
+    struct bpnode *node;
+
+    assert(tree != NULL);
+
+    for (node = tree->root; !node->leaf; node = node->children[0]);
+
+    if (node->count == 0) return FALSE;
+
+    if (key != NULL) *key = node->keys[0];
+
+    if (value != NULL) *value = node->values[0];
+
+    return TRUE;
+
+}
+
+int bptreeMax(struct bptree *tree, unsigned int *key, void **value){
+
+    struct bpnode *node;
+
+    assert(tree != NULL);
+
+    for (node = tree->root; !node->leaf; node = node->children[node->count]);
+
+    if (node->count == 0) return FALSE;
+
+    if (key != NULL) *key = node->keys[node->count - 1];
+
+    if (value != NULL) *value = node->values[node->count - 1];
+
+    return TRUE;
+
+}
+
+int bptreePred(struct bptree *tree, unsigned int key, unsigned int *pkey, void **pvalue){
+
+    /*
+        Richiede: struttura dati B+albero non nulla
+        Effetto: scrive in pkey e pvalue (se non NULL) la massima chiave strettamente minore di key
+                    e il valore associato e restituisce TRUE; se non esiste restituisce FALSE.
+    */
+
+    struct bpnode *leaf;
+    unsigned int pos;
+
+    assert(tree != NULL);
+
+    // Le chiavi minori di key si trovano nella foglia di key oppure, se è la prima, nella foglia precedente
+    if ((pos = countLess((leaf = findLeaf(tree, key)), key)) == 0){
+
+        if ((leaf = leaf->prev) == NULL) return FALSE;
+
+        pos = leaf->count;
+
+    }
+
+    if (pkey != NULL) *pkey = leaf->keys[pos - 1];
+
+    if (pvalue != NULL) *pvalue = leaf->values[pos - 1];
+
+    return TRUE;
+
+}
+
+void bptreeSeek(struct bpcursor *cursor, struct bptree *tree, unsigned int key){
+
+    /*
+        Richiede: cursore e struttura dati B+albero non nulli
+        Effetto: posiziona il cursore sulla prima chiave >= key; le successive chiamate a bptreeNext
+                    restituiscono le chiavi in ordine crescente fino alla fine dell'albero.
+                    bptreeSeek(cursor, tree, 0) visita l'intero albero.
+    */
+
+    struct bpnode *leaf;
+    unsigned int pos;
+
+    assert(cursor != NULL && tree != NULL);
+
+    pos = countLess((leaf = findLeaf(tree, key)), key);
+
+    if (pos == leaf->count) leaf = leaf->next, pos = 0;
+
+    cursor->leaf = leaf;
+    cursor->index = pos;
+    cursor->bounded = FALSE;
+
+}
+
+void bptreeRangeIter(struct bpcursor *cursor, struct bptree *tree, unsigned int lo, unsigned int hi){
+
+    /*
+        Richiede: cursore e struttura dati B+albero non nulli
+        Effetto: prepara il cursore per visitare in ordine le sole chiavi comprese nell'intervallo [lo, hi)
+    */
+
+    bptreeSeek(cursor, tree, lo);
+
+    cursor->bounded = TRUE;
+    cursor->hi = hi;
+
+}
+
+int bptreeNext(struct bpcursor *cursor, unsigned int *key, void **value){
+
+    /*
+        Richiede: cursore inizializzato con bptreeSeek o bptreeRangeIter
+        Effetto: se la visita non è terminata scrive in key e value (se non NULL) la prossima chiave e il
+                    valore associato, avanza il cursore e restituisce TRUE; altrimenti restituisce FALSE.
+        Attenzione: il cursore non è più valido se l'albero viene modificato durante la visita.
+    */
+
+    struct bpnode *leaf;
+
+    assert(cursor != NULL);
+
+    if ((leaf = cursor->leaf) == NULL) return FALSE;
+
+    if (cursor->bounded && leaf->keys[cursor->index] >= cursor->hi){
+
+        cursor->leaf = NULL;
+
+        return FALSE;
+
+    }
+
+    if (key != NULL) *key = leaf->keys[cursor->index];
+
+    if (value != NULL) *value = leaf->values[cursor->index];
+
+    if (++cursor->index == leaf->count){
+
+        cursor->leaf = leaf->next;
+        cursor->index = 0;
+
+    }
+
+    return TRUE;
+
+}
+
+// Libera ricorsivamente il sottoalbero (la profondità è logaritmica in base BPTREE_MIN)
+static void destroyNode(struct bpnode *node){
+
+    if (!node->leaf) for (unsigned int i=0; i<=node->count; i++) destroyNode(node->children[i]);
+
+    free(node);
+
+}
+
+void destroyBPTree(struct bptree *tree){
+
+    /*
+        Richiede: struttura dati B+albero non nulla
+        Effetto: dealloca lo spazio riservato a ciascun nodo e alla struttura dati stessa.
+
+        Attenzione: non dealloca lo spazio riservato ai valori!
+    */
+
+    assert(tree != NULL);
+
+    destroyNode(tree->root);
+
+    free(tree);
+
+}
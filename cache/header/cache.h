@@ -0,0 +1,26 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+// Politiche di rimpiazzamento
+#define CACHE_LRU 0
+#define CACHE_CLOCK 1
+
+typedef struct cache cache;
+
+
+struct cache* newCache(unsigned int capacity, unsigned long maxbytes, unsigned int (*hash)(void*), unsigned int (*equal)(void*, void*), int policy, void (*evict)(void *key, void *object));
+
+void* cacheGet(struct cache *cache, void *key);
+
+void* cachePut(struct cache *cache, void *key, void *object, unsigned long bytes);
+
+void* cacheRemove(struct cache *cache, void *key);
+
+unsigned int cacheCount(struct cache *cache);
+
+unsigned long cacheBytes(struct cache *cache);
+
+void destroyCache(struct cache *cache);
+
+
+#endif
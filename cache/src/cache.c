@@ -0,0 +1,460 @@
+#include "../header/cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#define TRUE 1
+#define FALSE 0
+
+
+// Elemento della cache: appartiene sia ad una lista di collisione dell'indice hash
+// sia all'anello che ne ordina gli accessi (collegamenti intrusivi, nessuna allocazione separata)
+struct entry {
+
+    // Elemento successivo nella lista di collisione
+    struct entry *hnext;
+
+    // Elementi precedente e successivo nell'anello di recenza
+    struct entry *prev, *next;
+
+    // Hash completo (rimescolato) della chiave
+    unsigned int hash;
+
+    // Bit di riferimento (CACHE_CLOCK)
+    int referenced;
+
+    // Dimensione dichiarata dell'oggetto
+    unsigned long bytes;
+
+    void *key;
+
+    void *object;
+
+};
+
+typedef struct cache {
+
+    // CACHE_LRU o CACHE_CLOCK
+    int policy;
+
+    // Indice hash: array di liste di collisione, size è una potenza di 2
+    struct entry **buckets;
+
+    unsigned int size;
+
+    // Anello degli elementi. CACHE_LRU: hand è l'elemento usato meno di recente e hand->prev quello usato
+    // più di recente. CACHE_CLOCK: hand è la lancetta che scorre l'anello alla ricerca di un elemento da rimuovere
+    struct entry *hand;
+
+    // Limiti sul numero di elementi e sulla somma delle dimensioni (0 indica nessun limite)
+    unsigned int capacity;
+
+    unsigned long maxbytes;
+
+    // Numero di elementi e somma delle loro dimensioni
+    unsigned int count;
+
+    unsigned long bytes;
+
+    // Se la capacità è limitata gli elementi sono ricavati da un unico blocco allocato alla creazione
+    struct entry *block;
+
+    // Elementi liberi, riutilizzati dagli inserimenti successivi
+    struct entry *freelist;
+
+    unsigned int (*hash)(void*);
+
+    unsigned int (*equal)(void*, void*);
+
+    // Funzione chiamata su ogni elemento rimosso per fare spazio (può essere NULL)
+    void (*evict)(void*, void*);
+
+} *Cache;
+
+
+// Define static safe malloc that prevents from memory allocations error
+static void* smalloc(size_t size){
+
+    void* object = malloc(size);
+
+    if (object == NULL) {
+
+        fprintf(stderr, "Memory allocation error\n");
+
+        exit(0);
+
+    }
+
+    return object;
+
+}
+
+// Rimescola i bit dell'hash restituito dalla funzione utente (finalizzatore di murmur3)
+static inline unsigned int mix(unsigned int h){
+
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+
+    return h;
+
+}
+
+static struct entry** allocBuckets(unsigned int size){
+
+    struct entry **buckets = smalloc((size_t) size * sizeof(struct entry*));
+
+    for (unsigned int i=0; i<size; i++) buckets[i] = NULL;
+
+    return buckets;
+
+}
+
+// Restituisce il puntatore al campo che punta all'elemento con la chiave cercata, NULL se la chiave non è presente
+static struct entry** find(struct cache *cache, void *key, unsigned int hashed){
+
+    struct entry **plist, *temp;
+
+    for (plist = &(cache->buckets[hashed & (cache->size - 1)]); (temp = *plist) != NULL; plist = &(temp->hnext))
+
+        if (temp->hash == hashed && cache->equal(temp->key, key)) return plist;
+
+    return NULL;
+
+}
+
+static void unlinkEntry(struct cache *cache, struct entry *entry){
+
+    if (entry->next == entry) {
+
+        cache->hand = NULL;
+
+        return;
+
+    }
+
+    entry->prev->next = entry->next;
+    entry->next->prev = entry->prev;
+
+    if (cache->hand == entry) cache->hand = entry->next;
+
+}
+
+// Inserisce l'elemento subito prima della lancetta: in CACHE_LRU diventa il più recente,
+// in CACHE_CLOCK sarà l'ultimo ad essere esaminato dalla lancetta
+static void linkBeforeHand(struct cache *cache, struct entry *entry){
+
+    struct entry *hand;
+
+    if ((hand = cache->hand) == NULL){
+
+        entry->prev = entry->next = cache->hand = entry;
+
+        return;
+
+    }
+
+    entry->next = hand;
+    entry->prev = hand->prev;
+
+    hand->prev->next = entry;
+    hand->prev = entry;
+
+}
+
+// Registra un accesso: CACHE_LRU sposta l'elemento in fondo all'anello, CACHE_CLOCK si limita
+// ad impostare il bit di riferimento senza scrivere nei collegamenti
+static void touch(struct cache *cache, struct entry *entry){
+
+    if (cache->policy == CACHE_CLOCK){
+
+        entry->referenced = TRUE;
+
+        return;
+
+    }
+
+    if (entry == cache->hand->prev) return;
+
+    unlinkEntry(cache, entry);
+
+    linkBeforeHand(cache, entry);
+
+}
+
+// Rimuove l'elemento dall'indice e dall'anello e lo restituisce alla lista degli elementi liberi
+static void removeEntry(struct cache *cache, struct entry **plist){
+
+    struct entry *entry = *plist;
+
+    *plist = entry->hnext;
+
+    unlinkEntry(cache, entry);
+
+    cache->count--;
+    cache->bytes -= entry->bytes;
+
+    entry->hnext = cache->freelist;
+    cache->freelist = entry;
+
+}
+
+// Rimuove l'elemento indicato dalla politica di rimpiazzamento e lo passa alla funzione evict
+static void evictOne(struct cache *cache){
+
+    struct entry *victim, **plist;
+
+    if (cache->policy == CACHE_CLOCK){
+
+        // La lancetta concede una seconda possibilità agli elementi usati dall'ultimo passaggio
+        while (cache->hand->referenced){
+
+            cache->hand->referenced = FALSE;
+            cache->hand = cache->hand->next;
+
+        }
+
+    }
+
+    victim = cache->hand;
+
+    for (plist = &(cache->buckets[victim->hash & (cache->size - 1)]); *plist != victim; plist = &((*plist)->hnext));
+
+    removeEntry(cache, plist);
+
+    if (cache->evict != NULL) cache->evict(victim->key, victim->object);
+
+}
+
+// Raddoppia l'indice hash (solo per cache senza limite sul numero di elementi)
+static void grow(struct cache *cache){
+
+    struct entry **buckets = cache->buckets, *temp, *next;
+    unsigned int size = cache->size;
+
+    cache->buckets = allocBuckets((cache->size = size * 2));
+
+    for (unsigned int i=0; i<size; i++)
+
+        for (temp = buckets[i]; temp != NULL; temp = next){
+
+            next = temp->hnext;
+
+            temp->hnext = cache->buckets[temp->hash & (cache->size - 1)];
+            cache->buckets[temp->hash & (cache->size - 1)] = temp;
+
+        }
+
+    free(buckets);
+
+}
+
+struct cache* newCache(unsigned int capacity, unsigned long maxbytes, unsigned int (*hashcode)(void*), unsigned int (*equal)(void*, void*), int policy, void (*evict)(void*, void*)){
+
+    /*
+        Richiede: funzioni hash e equal non nulle, politica CACHE_LRU o CACHE_CLOCK
+        Effetto: crea una cache vuota che contiene al più capacity elementi e al più maxbytes byte
+                    (somma delle dimensioni dichiarate in cachePut); un limite pari a 0 è disattivato.
+                    Quando un inserimento supera uno dei limiti la cache rimuove gli elementi indicati dalla
+                    politica e li passa alla funzione evict (se non NULL):
+                    CACHE_LRU rimuove l'elemento usato meno di recente,
+                    CACHE_CLOCK approssima LRU con un bit di riferimento per elemento, evitando di
+                    modificare i collegamenti ad ogni accesso.
+                    Se capacity è positivo tutti gli elementi vengono allocati alla creazione.
+    */
+
+    struct cache *cache;
+    unsigned int size;
+
+    assert(hashcode != NULL && equal != NULL);
+    assert(policy == CACHE_LRU || policy == CACHE_CLOCK);
+
+    for (size = 1; size < capacity; size <<= 1);
+
+    *(cache = smalloc(sizeof(struct cache))) = (struct cache) {
+        .policy=policy, .buckets=allocBuckets(size), .size=size, .hand=NULL,
+        .capacity=capacity, .maxbytes=maxbytes, .count=0, .bytes=0,
+        .block=NULL, .freelist=NULL, .hash=hashcode, .equal=equal, .evict=evict
+    };
+
+    if (capacity > 0){
+
+        cache->block = smalloc(capacity * sizeof(struct entry));
+
+        for (unsigned int i=0; i<capacity; i++){
+
+            cache->block[i].hnext = cache->freelist;
+            cache->freelist = &(cache->block[i]);
+
+        }
+
+    }
+
+    return cache;
+
+}
+
+void* cacheGet(struct cache *cache, void *key){
+
+    /*
+        Richiede: struttura cache non nulla
+        Effetto: restituisce l'oggetto associato alla chiave (NULL se assente) e ne registra l'accesso
+    */
+
+    struct entry **plist;
+
+    assert(cache != NULL);
+
+    if ((plist = find(cache, key, mix(cache->hash(key)))) == NULL) return NULL;
+
+    touch(cache, *plist);
+
+    return (*plist)->object;
+
+}
+
+void* cachePut(struct cache *cache, void *key, void *object, unsigned long bytes){
+
+    /*
+        Richiede: struttura cache non nulla
+        Effetto: associa l'oggetto (di dimensione bytes) alla chiave, registrandone l'accesso.
+                    Se la chiave era già presente restituisce l'oggetto precedente, che non viene passato
+                    alla funzione evict; altrimenti restituisce NULL.
+                    Un oggetto più grande di maxbytes viene rimosso subito dopo l'inserimento.
+    */
+
+    struct entry **plist, *entry;
+    unsigned int hashed;
+    void *previous = NULL;
+
+    assert(cache != NULL);
+
+    hashed = mix(cache->hash(key));
+
+    if ((plist = find(cache, key, hashed)) != NULL){
+
+        entry = *plist;
+        previous = entry->object;
+
+        cache->bytes += bytes - entry->bytes;
+
+        entry->object = object;
+        entry->bytes = bytes;
+
+        touch(cache, entry);
+
+    }
+
+    else {
+
+        // Con la capacità esaurita fa spazio prima di prelevare un elemento libero
+        if (cache->capacity > 0 && cache->count == cache->capacity) evictOne(cache);
+
+        if ((entry = cache->freelist) != NULL) cache->freelist = entry->hnext;
+
+        else entry = smalloc(sizeof(struct entry));
+
+        *entry = (struct entry) {
+            .hnext=cache->buckets[hashed & (cache->size - 1)], .hash=hashed,
+            .referenced=FALSE, .bytes=bytes, .key=key, .object=object
+        };
+
+        cache->buckets[hashed & (cache->size - 1)] = entry;
+
+        linkBeforeHand(cache, entry);
+
+        cache->count++;
+        cache->bytes += bytes;
+
+        if (cache->count > cache->size) grow(cache);
+
+    }
+
+    while (cache->maxbytes > 0 && cache->bytes > cache->maxbytes) evictOne(cache);
+
+    return previous;
+
+}
+
+void* cacheRemove(struct cache *cache, void *key){
+
+    /*
+        Richiede: struttura cache non nulla
+        Effetto: rimuove la chiave dalla cache e restituisce l'oggetto associato (NULL se assente),
+                    senza chiamare la funzione evict.
+    */
+
+    struct entry **plist;
+    void *object;
+
+    assert(cache != NULL);
+
+    if ((plist = find(cache, key, mix(cache->hash(key)))) == NULL) return NULL;
+
+    object = (*plist)->object;
+
+    removeEntry(cache, plist);
+
+    return object;
+
+}
+
+unsigned int cacheCount(struct cache *cache){
+
+    assert(cache != NULL);
+
+    return cache->count;
+
+}
+
+unsigned long cacheBytes(struct cache *cache){
+
+    assert(cache != NULL);
+
+    return cache->bytes;
+
+}
+
+void destroyCache(struct cache *cache){
+
+    /*
+        Richiede: struttura cache non nulla
+        Effetto: passa alla funzione evict (se non NULL) ciascun elemento ancora presente,
+                    quindi libera lo spazio riservato agli elementi e alla cache stessa.
+    */
+
+    struct entry *entry, *next;
+
+    assert(cache != NULL);
+
+    while (cache->hand != NULL){
+
+        entry = cache->hand;
+
+        unlinkEntry(cache, entry);
+
+        if (cache->evict != NULL) cache->evict(entry->key, entry->object);
+
+        if (cache->block == NULL) free(entry);
+
+    }
+
+    if (cache->block == NULL){
+
+        for (entry = cache->freelist; entry != NULL; entry = next){
+
+            next = entry->hnext;
+
+            free(entry);
+
+        }
+
+    }
+
+    free(cache->block);
+    free(cache->buckets);
+    free(cache);
+
+}
@@ -0,0 +1,13 @@
+#ifndef EPOCH_H
+#define EPOCH_H
+
+void epochEnter();
+
+void epochExit();
+
+void epochRetire(void *object, void (*destroy)(void*));
+
+void epochThreadExit();
+
+
+#endif
@@ -0,0 +1,257 @@
+#include "../header/epoch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <assert.h>
+
+#define TRUE 1
+#define FALSE 0
+
+// Bit meno significativo dello stato di un thread: attivo se il thread si trova in una sezione critica
+#define ACTIVE 1UL
+
+// Numero di oggetti ritirati dopo il quale un thread prova ad avanzare l'epoca e a liberare memoria
+#define RETIRE_THRESHOLD 64
+
+// Oggetto rimosso da una struttura condivisa, in attesa che nessun lettore possa più raggiungerlo
+struct retired {
+
+    struct retired *next;
+
+    void *object;
+
+    void (*destroy)(void*);
+
+};
+
+// Stato di un thread registrato
+struct record {
+
+    // Epoca osservata all'ingresso nella sezione critica (bit alti) e flag ACTIVE
+    _Atomic unsigned long state;
+
+    // Vero se il record è assegnato ad un thread
+    _Atomic int inuse;
+
+    // Elenco dei record (in sola aggiunta)
+    struct record *next;
+
+    // Profondità di annidamento delle sezioni critiche del thread
+    unsigned int nesting;
+
+    // Numero di oggetti ritirati dall'ultimo tentativo di recupero
+    unsigned int pending;
+
+    // Oggetti ritirati, raggruppati in base all'epoca (modulo 3) in cui sono stati ritirati
+    struct { unsigned long epoch; struct retired *list; } limbo[3];
+
+};
+
+
+static _Atomic unsigned long global_epoch = 0;
+
+static struct record *_Atomic records = NULL;
+
+static _Thread_local struct record *self = NULL;
+
+
+// Define static safe malloc that prevents from memory allocations error
+static void* smalloc(unsigned int size){
+
+    void* object = malloc(size);
+
+    if (object == NULL) {
+
+        fprintf(stderr, "Memory allocation error\n");
+
+        exit(0);
+
+    }
+
+    return object;
+
+}
+
+// Assegna al thread un record libero oppure ne registra uno nuovo.
+// Un record riutilizzato conserva gli oggetti ritirati dal thread precedente, che verranno liberati da questo
+static struct record* acquire(){
+
+    struct record *record, *head;
+    int expected;
+
+    for (record = atomic_load(&records); record != NULL; record = record->next){
+
+        expected = FALSE;
+
+        if (atomic_compare_exchange_strong(&(record->inuse), &expected, TRUE)) return record;
+
+    }
+
+    record = smalloc(sizeof(struct record));
+    record->nesting = 0;
+    record->pending = 0;
+
+    for (int i=0; i<3; i++) record->limbo[i].list = NULL;
+
+    atomic_init(&(record->state), 0);
+    atomic_init(&(record->inuse), TRUE);
+
+    head = atomic_load(&records);
+
+    do { record->next = head; } while (!atomic_compare_exchange_weak(&records, &head, record));
+
+    return record;
+
+}
+
+// Avanza l'epoca globale se tutti i thread attivi hanno già osservato quella corrente
+static void tryAdvance(){
+
+    struct record *record;
+    unsigned long epoch = atomic_load(&global_epoch), state;
+
+    for (record = atomic_load(&records); record != NULL; record = record->next){
+
+        if (!atomic_load(&(record->inuse))) continue;
+
+        if (((state = atomic_load(&(record->state))) & ACTIVE) && (state >> 1) != epoch) return;
+
+    }
+
+    atomic_compare_exchange_strong(&global_epoch, &epoch, epoch + 1);
+
+}
+
+static void freeList(struct retired *list){
+
+    struct retired *next;
+
+    for (; list != NULL; list = next){
+
+        next = list->next;
+
+        list->destroy(list->object);
+
+        free(list);
+
+    }
+
+}
+
+// Libera gli oggetti ritirati almeno due epoche fa: nessun lettore attivo può ancora raggiungerli
+static void reclaim(struct record *record){
+
+    unsigned long epoch = atomic_load(&global_epoch);
+
+    for (int i=0; i<3; i++){
+
+        if (record->limbo[i].list != NULL && record->limbo[i].epoch + 2 <= epoch){
+
+            freeList(record->limbo[i].list);
+
+            record->limbo[i].list = NULL;
+
+        }
+
+    }
+
+}
+
+void epochEnter(){
+
+    /*
+        Effetto: apre una sezione critica di lettura; fino alla corrispondente epochExit
+                    nessun oggetto ritirato con epochRetire dopo questa chiamata verrà liberato.
+                    Le sezioni critiche possono essere annidate.
+    */
+
+    if (self == NULL) self = acquire();
+
+    if (self->nesting++ == 0){
+
+        atomic_store(&(self->state), (atomic_load(&global_epoch) << 1) | ACTIVE);
+
+        // L'annuncio dell'epoca deve essere visibile prima di qualsiasi lettura della struttura condivisa
+        atomic_thread_fence(memory_order_seq_cst);
+
+    }
+
+}
+
+void epochExit(){
+
+    assert(self != NULL && self->nesting > 0);
+
+    if (--self->nesting == 0)
+
+        atomic_store_explicit(&(self->state), atomic_load_explicit(&(self->state), memory_order_relaxed) & ~ACTIVE, memory_order_release);
+
+}
+
+void epochRetire(void *object, void (*destroy)(void*)){
+
+    /*
+        Richiede: oggetto già reso irraggiungibile dalla struttura condivisa, funzione destroy non nulla
+        Effetto: chiama destroy sull'oggetto quando tutti i thread che potevano leggerlo
+                    sono usciti dalla loro sezione critica.
+    */
+
+    struct retired *retired;
+    unsigned long epoch;
+    int i;
+
+    assert(destroy != NULL);
+
+    if (self == NULL) self = acquire();
+
+    epoch = atomic_load(&global_epoch);
+
+    // Lo slot dell'epoca corrente può contenere oggetti di tre o più epoche fa, che sono già liberabili
+    if (self->limbo[(i = epoch % 3)].list != NULL && self->limbo[i].epoch != epoch){
+
+        freeList(self->limbo[i].list);
+
+        self->limbo[i].list = NULL;
+
+    }
+
+    *(retired = smalloc(sizeof(struct retired))) = (struct retired) {
+        .next=self->limbo[i].list, .object=object, .destroy=destroy
+    };
+
+    self->limbo[i].list = retired;
+    self->limbo[i].epoch = epoch;
+
+    if (++self->pending >= RETIRE_THRESHOLD){
+
+        tryAdvance();
+
+        reclaim(self);
+
+        self->pending = 0;
+
+    }
+
+}
+
+void epochThreadExit(){
+
+    /*
+        Richiede: nessuna sezione critica aperta dal thread chiamante
+        Effetto: rilascia il record del thread; gli oggetti ritirati non ancora liberati
+                    passano al prossimo thread che riutilizzerà il record.
+    */
+
+    if (self == NULL) return;
+
+    assert(self->nesting == 0);
+
+    tryAdvance();
+
+    reclaim(self);
+
+    atomic_store(&(self->inuse), FALSE);
+
+    self = NULL;
+
+}
@@ -0,0 +1,20 @@
+#ifndef CHASHTABLE_H
+#define CHASHTABLE_H
+
+typedef struct chasht chashtable;
+
+
+struct chasht* newConcurrentHashTable(unsigned int size, unsigned int (*hash)(void*), unsigned int (*equal)(void*, void*));
+
+void* concurrentUpsertKey(struct chasht* hashtable, void *key, void* object);
+
+void concurrentDeleteKey(struct chasht* hashtable, void* key);
+
+unsigned int concurrentSearchKey(struct chasht* hashtable, void* key);
+
+void* concurrentGetObject(struct chasht *hashtable, void *key);
+
+void destroyConcurrentHashTable(struct chasht* hashtable);
+
+
+#endif
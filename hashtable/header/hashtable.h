@@ -1,14 +1,61 @@
+#ifndef HASHTABLE_H
+#define HASHTABLE_H
+
+// Modalità di memorizzazione della tabella hash
+#define HASHTABLE_CHAINED 0
+#define HASHTABLE_OPEN 1
+#define HASHTABLE_MAPPED 2
+
 typedef struct hasht hashtable;
 
+// Statistiche del filtro attivato con enableFilter
+typedef struct hashstats {
+
+    // Ricerche che hanno interrogato il filtro
+    unsigned long queries;
+
+    // Ricerche concluse dal solo filtro perchè la chiave è certamente assente
+    unsigned long filtered;
+
+    // Ricerche lasciate passare dal filtro per chiavi che poi sono risultate assenti
+    unsigned long falsepositives;
+
+    // falsepositives / (filtered + falsepositives)
+    double fprate;
+
+    // Memoria occupata dal filtro (0 se non attivo)
+    unsigned long filterbytes;
+
+} *HashStats;
+
 
 struct hasht* newHashTable(unsigned int size, unsigned int (*hash)(void*), unsigned int (*equal)(void*, void*));
 
+struct hasht* newHashTableMode(unsigned int size, unsigned int (*hash)(void*), unsigned int (*equal)(void*, void*), int mode);
+
 void insertKey(struct hasht* hashtable, void *key, void* object);
 
+void* upsertKey(struct hasht* hashtable, void *key, void* object);
+
 void deleteKey(struct hasht* hashtable, void* key);
 
 unsigned int searchKey(struct hasht* hashtable, void* key);
 
 void* getObject(struct hasht *hashtable, void *key);
 
+void getObjectBatch(struct hasht *hashtable, void **keys, unsigned int n, void **out);
+
+void searchKeyBatch(struct hasht *hashtable, void **keys, unsigned int n, unsigned int *out);
+
 void destroyHashTable(struct hasht* hashtable);
+
+int saveHashTable(struct hasht *hashtable, const char *path, unsigned int (*keybytes)(void*, const void**), unsigned int (*objectbytes)(void*, const void**));
+
+void enableFilter(struct hasht *hashtable);
+
+void hashTableStats(struct hasht *hashtable, struct hashstats *stats);
+
+struct hasht* mapHashTable(const char *path, unsigned int (*hash)(void*), unsigned int (*keybytes)(void*, const void**), int verify);
+
+
+#endif
@@ -0,0 +1,251 @@
+#ifndef TYPEDHASHTABLE_H
+#define TYPEDHASHTABLE_H
+
+/*
+    Tabella hash specializzata a tempo di compilazione.
+
+    HASHTABLE_DECLARE(name, K, V, hash, equal) genera la struttura struct name e le funzioni
+
+        struct name* name##_new(unsigned int size);
+        void name##_insert(struct name *table, K key, V value);
+        int name##_upsert(struct name *table, K key, V value, V *previous);
+        int name##_get(struct name *table, K key, V *value);
+        unsigned int name##_search(struct name *table, K key);
+        void name##_delete(struct name *table, K key);
+        void name##_destroy(struct name *table);
+
+    che hanno la stessa semantica di newHashTableMode(..., HASHTABLE_OPEN), insertKey, upsertKey,
+    getObject, searchKey, deleteKey e destroyHashTable, ma memorizzano chiavi e valori direttamente
+    negli slot (senza void*) e chiamano hash e equal senza passare da puntatori a funzione, così che
+    il compilatore possa espanderle in linea. hash(key) restituisce un unsigned int a 32 bit qualsiasi,
+    equal(a, b) un valore non nullo se le chiavi sono uguali; possono essere funzioni o macro.
+    A differenza della tabella generica la crescita ricostruisce l'array in un'unica operazione.
+
+    e.g.    HASHTABLE_DECLARE(u32map, uint32_t, void*, typedHashU32, typedEqual)
+            HASHTABLE_DECLARE(u64map, uint64_t, uint64_t, typedHashU64, typedEqual)
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Stessi parametri della modalità HASHTABLE_OPEN di hashtable.c
+#define TYPED_GROUP_WIDTH 16
+#define TYPED_CTRL_EMPTY ((signed char) -128)
+#define TYPED_CTRL_DELETED ((signed char) -2)
+#define TYPED_H1(h) ((h) >> 7)
+#define TYPED_H2(h) ((signed char) ((h) & 0x7F))
+
+// Funzioni hash e di uguaglianza per chiavi intere
+#define typedHashU32(key) ((unsigned int) (key))
+#define typedHashU64(key) ((unsigned int) ((key) ^ ((key) >> 32)))
+#define typedEqual(a, b) ((a) == (b))
+
+
+static inline void* typedSmalloc(size_t size){
+
+    void* object = malloc(size);
+
+    if (object == NULL) {
+
+        fprintf(stderr, "Memory allocation error\n");
+
+        exit(0);
+
+    }
+
+    return object;
+
+}
+
+static inline unsigned int typedMix(unsigned int h){
+
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+
+    return h;
+
+}
+
+static inline unsigned int typedMatchByte(const signed char *group, signed char c){
+
+#ifdef __SSE2__
+
+    return (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(c), _mm_loadu_si128((const __m128i*) group)));
+
+#else
+
+    unsigned int mask = 0;
+
+    for (int i=0; i<TYPED_GROUP_WIDTH; i++) if (group[i] == c) mask |= 1u << i;
+
+    return mask;
+
+#endif
+
+}
+
+static inline unsigned int typedMatchFree(const signed char *group){
+
+#ifdef __SSE2__
+
+    return (unsigned int) _mm_movemask_epi8(_mm_loadu_si128((const __m128i*) group));
+
+#else
+
+    unsigned int mask = 0;
+
+    for (int i=0; i<TYPED_GROUP_WIDTH; i++) if (group[i] < 0) mask |= 1u << i;
+
+    return mask;
+
+#endif
+
+}
+
+
+#define HASHTABLE_DECLARE(name, K, V, hash, equal)                                                          \
+                                                                                                            \
+struct name##_slot { K key; V value; };                                                                     \
+                                                                                                            \
+struct name {                                                                                               \
+    signed char *ctrl;                                                                                      \
+    struct name##_slot *slots;                                                                              \
+    unsigned int size, used, deleted;                                                                       \
+};                                                                                                          \
+                                                                                                            \
+static inline void name##_alloc(struct name *table, unsigned int size){                                     \
+    table->ctrl = typedSmalloc(size + TYPED_GROUP_WIDTH);                                                   \
+    table->slots = typedSmalloc(size * sizeof(struct name##_slot));                                         \
+    table->size = size;                                                                                     \
+    table->used = 0;                                                                                        \
+    table->deleted = 0;                                                                                     \
+    memset(table->ctrl, TYPED_CTRL_EMPTY, size + TYPED_GROUP_WIDTH);                                        \
+}                                                                                                           \
+                                                                                                            \
+static inline void name##_setctrl(struct name *table, unsigned int i, signed char c){                       \
+    table->ctrl[i] = c;                                                                                     \
+    if (i < TYPED_GROUP_WIDTH) table->ctrl[table->size + i] = c;                                            \
+}                                                                                                           \
+                                                                                                            \
+static inline long name##_find(struct name *table, K key, unsigned int hashed, long *freeslot){            \
+    unsigned int mask = table->size - 1, pos = TYPED_H1(hashed) & mask, step = 0, match;                    \
+    const signed char *group;                                                                               \
+    if (freeslot != NULL) *freeslot = -1;                                                                   \
+    for (;;) {                                                                                              \
+        group = table->ctrl + pos;                                                                          \
+        for (match = typedMatchByte(group, TYPED_H2(hashed)); match != 0; match &= match - 1) {             \
+            unsigned int i = (pos + __builtin_ctz(match)) & mask;                                           \
+            if (equal(table->slots[i].key, key)) return i;                                                  \
+        }                                                                                                   \
+        if (freeslot != NULL && *freeslot < 0 && (match = typedMatchFree(group)) != 0)                      \
+            *freeslot = (pos + __builtin_ctz(match)) & mask;                                                \
+        if (typedMatchByte(group, TYPED_CTRL_EMPTY) != 0) return -1;                                        \
+        step += TYPED_GROUP_WIDTH;                                                                          \
+        pos = (pos + step) & mask;                                                                          \
+    }                                                                                                       \
+}                                                                                                           \
+                                                                                                            \
+static inline void name##_place(struct name *table, unsigned int i, K key, V value, unsigned int hashed){    \
+    if (table->ctrl[i] == TYPED_CTRL_DELETED) table->deleted--;                                             \
+    name##_setctrl(table, i, TYPED_H2(hashed));                                                             \
+    table->slots[i].key = key;                                                                              \
+    table->slots[i].value = value;                                                                          \
+    table->used++;                                                                                          \
+}                                                                                                           \
+                                                                                                            \
+static inline unsigned int name##_findfree(struct name *table, unsigned int hashed){                        \
+    unsigned int mask = table->size - 1, pos = TYPED_H1(hashed) & mask, step = 0, match;                    \
+    while ((match = typedMatchFree(table->ctrl + pos)) == 0) {                                              \
+        step += TYPED_GROUP_WIDTH;                                                                          \
+        pos = (pos + step) & mask;                                                                          \
+    }                                                                                                       \
+    return (pos + __builtin_ctz(match)) & mask;                                                             \
+}                                                                                                           \
+                                                                                                            \
+/* Mantiene gli slot non vuoti sotto i 7/8, raddoppiando o eliminando i marcatori di cancellazione */      \
+static inline void name##_reserve(struct name *table){                                                      \
+    signed char *ctrl;                                                                                      \
+    struct name##_slot *slots;                                                                              \
+    unsigned int size, i, hashed;                                                                           \
+    if ((table->used + table->deleted + 1) * 8 <= table->size * 7) return;                                  \
+    ctrl = table->ctrl, slots = table->slots, size = table->size;                                           \
+    name##_alloc(table, (table->used + 1) * 16 > size * 7 ? size * 2 : size);                               \
+    for (i = 0; i < size; i++) {                                                                            \
+        if (ctrl[i] < 0) continue;                                                                          \
+        hashed = typedMix(hash(slots[i].key));                                                              \
+        name##_place(table, name##_findfree(table, hashed), slots[i].key, slots[i].value, hashed);          \
+    }                                                                                                       \
+    free(ctrl);                                                                                             \
+    free(slots);                                                                                            \
+}                                                                                                           \
+                                                                                                            \
+static inline struct name* name##_new(unsigned int size){                                                   \
+    struct name *table = typedSmalloc(sizeof(struct name));                                                 \
+    unsigned int capacity;                                                                                  \
+    for (capacity = TYPED_GROUP_WIDTH; capacity < size; capacity <<= 1);                                    \
+    name##_alloc(table, capacity);                                                                          \
+    return table;                                                                                           \
+}                                                                                                           \
+                                                                                                            \
+static inline void name##_insert(struct name *table, K key, V value){                                       \
+    unsigned int hashed = typedMix(hash(key));                                                              \
+    assert(table != NULL);                                                                                  \
+    name##_reserve(table);                                                                                  \
+    name##_place(table, name##_findfree(table, hashed), key, value, hashed);                                \
+}                                                                                                           \
+                                                                                                            \
+static inline int name##_upsert(struct name *table, K key, V value, V *previous){                           \
+    unsigned int hashed = typedMix(hash(key));                                                              \
+    long i, freeslot;                                                                                       \
+    assert(table != NULL);                                                                                  \
+    name##_reserve(table);                                                                                  \
+    if ((i = name##_find(table, key, hashed, &freeslot)) >= 0) {                                            \
+        if (previous != NULL) *previous = table->slots[i].value;                                            \
+        table->slots[i].value = value;                                                                      \
+        return 1;                                                                                           \
+    }                                                                                                       \
+    name##_place(table, freeslot, key, value, hashed);                                                      \
+    return 0;                                                                                               \
+}                                                                                                           \
+                                                                                                            \
+static inline int name##_get(struct name *table, K key, V *value){                                          \
+    long i;                                                                                                 \
+    assert(table != NULL);                                                                                  \
+    if ((i = name##_find(table, key, typedMix(hash(key)), NULL)) < 0) return 0;                             \
+    if (value != NULL) *value = table->slots[i].value;                                                      \
+    return 1;                                                                                               \
+}                                                                                                           \
+                                                                                                            \
+static inline unsigned int name##_search(struct name *table, K key){                                        \
+    assert(table != NULL);                                                                                  \
+    return name##_find(table, key, typedMix(hash(key)), NULL) >= 0 ? 1 : 0;                                 \
+}                                                                                                           \
+                                                                                                            \
+static inline void name##_delete(struct name *table, K key){                                                \
+    long i;                                                                                                 \
+    assert(table != NULL);                                                                                  \
+    if ((i = name##_find(table, key, typedMix(hash(key)), NULL)) < 0) return;                               \
+    name##_setctrl(table, i, TYPED_CTRL_DELETED);                                                           \
+    table->used--;                                                                                          \
+    table->deleted++;                                                                                       \
+}                                                                                                           \
+                                                                                                            \
+static inline void name##_destroy(struct name *table){                                                      \
+    assert(table != NULL);                                                                                  \
+    free(table->ctrl);                                                                                      \
+    free(table->slots);                                                                                     \
+    free(table);                                                                                            \
+}
+
+
+#endif
@@ -0,0 +1,481 @@
+#include "../../epoch/header/epoch.h"  // Require use of epoch reclamation (you can find it inside repo)
+#include "../header/chashtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <assert.h>
+
+#define TRUE 1
+#define FALSE 0
+
+// Numero di lock in cui sono partizionati i bucket (potenza di 2)
+#define STRIPES 64u
+
+// Numero massimo di segmenti di bucket: il segmento 0 contiene i primi STRIPES bucket, il segmento k > 0
+// i bucket [STRIPES * 2^(k-1), STRIPES * 2^k), quindi la tabella arriva a MAXBUCKETS = 2^31 bucket
+#define SEGMENTS 26
+#define MAXBUCKETS (STRIPES << (SEGMENTS - 1))
+
+// Sentinelle dei nuovi bucket che ogni inserimento aggiunge alla lista dopo una crescita: la partizione
+// completa le proprie prima della crescita successiva e le letture raramente devono partire da un antenato
+#define SPLITS 2
+
+/*
+    Gli elementi sono tenuti in un'unica lista ordinata per chiave "split-order", l'hash con i bit invertiti:
+    gli elementi di un bucket sono consecutivi e quando il numero di bucket raddoppia il bucket b si divide
+    in b e b + size senza spostare alcun nodo. Ogni bucket è un nodo sentinella (senza chiave) inserito
+    nella lista, che l'array di bucket rende raggiungibile direttamente. Una crescita alloca solo il segmento dei
+    nuovi bucket: le loro sentinelle vengono inserite nella lista dalle scritture successive, ciascuna sotto il lock
+    della propria partizione, e finchè mancano le ricerche partono dalla sentinella di un antenato.
+*/
+struct node {
+
+    // Nodo successivo nella lista, pubblicato in modo atomico per i lettori senza lock
+    struct node *_Atomic next;
+
+    // Chiave di ordinamento: hash invertito, dispari per gli elementi e pari per le sentinelle
+    unsigned int order;
+
+    // Hash completo (rimescolato) della chiave
+    unsigned int hash;
+
+    void *key;
+
+    // Nelle sentinelle vale la sentinella stessa una volta inserita nella lista, NULL prima
+    void *_Atomic object;
+
+};
+
+// Lock di una partizione di bucket, allineato alla linea di cache per evitare false condivisioni
+struct stripe {
+
+    _Alignas(64) pthread_mutex_t lock;
+
+    // Numero di elementi contenuti nei bucket della partizione
+    unsigned int used;
+
+    // Prossimo bucket della partizione la cui sentinella potrebbe non essere ancora nella lista
+    unsigned int pending;
+
+};
+
+typedef struct chasht {
+
+    // Numero di bucket in uso; cresce senza fermare le altre operazioni
+    _Atomic unsigned int size;
+
+    // Segmenti dell'array delle sentinelle dei bucket: vengono solo aggiunti, mai copiati o sostituiti
+    struct node *_Atomic segments[SEGMENTS];
+
+    // Il bucket i appartiene alla partizione i % STRIPES, così come gli elementi che lo seguono nella lista
+    // fino alla sentinella successiva: poichè il numero di bucket è un multiplo di STRIPES la partizione di una
+    // chiave non cambia quando la tabella cresce, e il suo lock protegge ogni modifica alla sua parte della lista
+    struct stripe stripes[STRIPES];
+
+    // Questa è la funzione che converte l'oggetto in un intero hash
+    unsigned int (*hash)(void*);
+
+    // Questa funzione permette di effettuare dei confronti sulle chiavi originali
+    unsigned int (*equal)(void*, void*);
+
+} *ConcurrentHashTable;
+
+
+// Define static safe malloc that prevents from memory allocations error
+static void* smalloc(size_t size){
+
+    void* object = malloc(size);
+
+    if (object == NULL) {
+
+        fprintf(stderr, "Memory allocation error\n");
+
+        exit(0);
+
+    }
+
+    return object;
+
+}
+
+// Rimescola i bit dell'hash restituito dalla funzione utente (finalizzatore di murmur3)
+static inline unsigned int mix(unsigned int h){
+
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+
+    return h;
+
+}
+
+// Inverte l'ordine dei bit: i bit meno significativi dell'hash, che scelgono il bucket, diventano i più significativi
+static inline unsigned int reverse(unsigned int h){
+
+    h = ((h >> 1) & 0x55555555) | ((h & 0x55555555) << 1);
+    h = ((h >> 2) & 0x33333333) | ((h & 0x33333333) << 2);
+    h = ((h >> 4) & 0x0F0F0F0F) | ((h & 0x0F0F0F0F) << 4);
+    h = ((h >> 8) & 0x00FF00FF) | ((h & 0x00FF00FF) << 8);
+
+    return (h >> 16) | (h << 16);
+
+}
+
+// Segmento di sentinelle azzerate, cioè non ancora inserite nella lista: con calloc i segmenti grandi
+// vengono forniti dal sistema già azzerati, senza che il thread che fa crescere la tabella debba scriverli
+static struct node* allocSegment(unsigned int size){
+
+    struct node *segment = calloc(size, sizeof(struct node));
+
+    if (segment == NULL) {
+
+        fprintf(stderr, "Memory allocation error\n");
+
+        exit(0);
+
+    }
+
+    return segment;
+
+}
+
+// Sentinella del bucket; il segmento deve essere già stato allocato
+static struct node* bucketSlot(struct chasht *hashtable, unsigned int bucket){
+
+    unsigned int segment = bucket < STRIPES ? 0 : 32 - __builtin_clz(bucket / STRIPES);
+    unsigned int offset = segment == 0 ? bucket : bucket - (STRIPES << (segment - 1));
+
+    return &(atomic_load_explicit(&(hashtable->segments[segment]), memory_order_acquire)[offset]);
+
+}
+
+// Bucket da cui il bucket si è separato: il numero di bucket era la metà quando quest'ultimo è stato creato
+static inline unsigned int parentBucket(unsigned int bucket){
+
+    return bucket & ~(0x80000000u >> __builtin_clz(bucket));
+
+}
+
+// Inserisce il nodo nella lista dopo start, mantenendo l'ordine; va chiamata con il lock della partizione
+static void listInsert(struct node *start, struct node *node){
+
+    struct node *pred, *next;
+
+    for (pred = start; (next = atomic_load_explicit(&(pred->next), memory_order_relaxed)) != NULL && next->order < node->order; pred = next);
+
+    atomic_init(&(node->next), next);
+
+    // Il nodo viene pubblicato solo dopo essere stato inizializzato completamente
+    atomic_store_explicit(&(pred->next), node, memory_order_release);
+
+}
+
+// Sentinella del bucket, inserita se necessario nella lista insieme a quelle degli antenati;
+// va chiamata con il lock della partizione del bucket, che è la stessa dei suoi antenati
+static struct node* bucketInit(struct chasht *hashtable, unsigned int bucket){
+
+    struct node *sentinel = bucketSlot(hashtable, bucket);
+
+    if (atomic_load_explicit(&(sentinel->object), memory_order_acquire) != NULL) return sentinel;
+
+    sentinel->order = reverse(bucket);
+    sentinel->hash = bucket;
+
+    // La sentinella del bucket 0 è la testa della lista
+    if (bucket != 0) listInsert(bucketInit(hashtable, parentBucket(bucket)), sentinel);
+
+    // Rende la sentinella utilizzabile dai lettori, che fino ad ora partivano da quella di un antenato
+    atomic_store_explicit(&(sentinel->object), sentinel, memory_order_release);
+
+    return sentinel;
+
+}
+
+// Sentinella da cui iniziare la ricerca di una chiave con l'hash dato, senza crearne di nuove:
+// se quella del bucket non esiste ancora i suoi elementi seguono la sentinella di un antenato
+static struct node* bucketStart(struct chasht *hashtable, unsigned int hashed){
+
+    unsigned int bucket = hashed & (atomic_load_explicit(&(hashtable->size), memory_order_acquire) - 1);
+    struct node *sentinel;
+
+    while (atomic_load_explicit(&((sentinel = bucketSlot(hashtable, bucket))->object), memory_order_acquire) == NULL) bucket = parentBucket(bucket);
+
+    return sentinel;
+
+}
+
+// Ricerca senza lock; deve essere chiamata all'interno di una sezione critica epochEnter/epochExit.
+// Un nodo rimosso mantiene il proprio puntatore al successivo, quindi un lettore fermo su di esso può proseguire
+static struct node* find(struct chasht *hashtable, void *key, unsigned int hashed){
+
+    unsigned int order = reverse(hashed) | 1;
+    struct node *node = bucketStart(hashtable, hashed);
+
+    for (node = atomic_load_explicit(&(node->next), memory_order_acquire); node != NULL && node->order <= order;
+            node = atomic_load_explicit(&(node->next), memory_order_acquire))
+
+        if (node->order == order && node->hash == hashed && hashtable->equal(node->key, key)) return node;
+
+    return NULL;
+
+}
+
+// Raddoppia il numero di bucket se è ancora quello osservato dal chiamante, senza acquisire lock.
+// Basta allocare il segmento dei nuovi bucket: nessun nodo viene spostato o copiato e le sentinelle
+// dei nuovi bucket vengono create dalle scritture successive, ciascuna sotto il lock della propria partizione
+static void grow(struct chasht *hashtable, unsigned int observed){
+
+    struct node *segment, *expected = NULL;
+    unsigned int index;
+
+    if (observed >= MAXBUCKETS) return;
+
+    // Il segmento dei bucket [observed, 2 * observed) è il primo non ancora allocato
+    index = 32 - __builtin_clz(observed / STRIPES);
+
+    if (atomic_load_explicit(&(hashtable->segments[index]), memory_order_acquire) == NULL){
+
+        segment = allocSegment(observed);
+
+        if (!atomic_compare_exchange_strong_explicit(&(hashtable->segments[index]), &expected, segment, memory_order_release, memory_order_relaxed))
+
+            free(segment);
+
+    }
+
+    // La pubblicazione della nuova dimensione segue quella del segmento
+    atomic_compare_exchange_strong_explicit(&(hashtable->size), &observed, observed * 2, memory_order_release, memory_order_relaxed);
+
+}
+
+struct chasht* newConcurrentHashTable(unsigned int size, unsigned int (*hashcode)(void*), unsigned int (*equal)(void*, void*)){
+
+    /*
+        Richiede: funzione hash e funzione equal non nulle
+        Effetto: crea una tabella hash condivisibile tra più thread senza sincronizzazione esterna.
+                    I bucket sono partizionati in STRIPES gruppi, ciascuno protetto dal proprio lock
+                    per le scritture; ricerche e letture non acquisiscono alcun lock.
+                    Come per newHashTable la funzione hash può restituire un qualsiasi valore a 32 bit.
+    */
+
+    struct node *tail, *sentinel;
+    unsigned int capacity, shift, i;
+
+    assert(hashcode != NULL && equal != NULL);
+
+    struct chasht* hashtable = smalloc(sizeof(struct chasht));
+    hashtable->hash = hashcode;
+    hashtable->equal = equal;
+
+    for (capacity = STRIPES, shift = 26; capacity < size && capacity < MAXBUCKETS; capacity <<= 1, shift--);
+
+    atomic_init(&(hashtable->size), capacity);
+
+    // Alloca i segmenti della capacità iniziale; le sentinelle dei primi STRIPES bucket esistono sempre
+    atomic_init(&(hashtable->segments[0]), allocSegment(STRIPES));
+
+    for (i=1; i<SEGMENTS; i++) atomic_init(&(hashtable->segments[i]), (STRIPES << (i - 1)) < capacity ? allocSegment(STRIPES << (i - 1)) : NULL);
+
+    // Inserisce tutte le sentinelle iniziali in coda alla lista, nell'ordine delle loro chiavi di ordinamento:
+    // la sentinella i-esima è quella del bucket con l'indice i invertito sui log2(capacity) bit
+    for (tail = bucketSlot(hashtable, 0), i = 0; i < capacity; i++, tail = sentinel){
+
+        sentinel = bucketSlot(hashtable, reverse(i) >> shift);
+        sentinel->order = i << shift;
+        sentinel->hash = reverse(i) >> shift;
+
+        if (i > 0) atomic_init(&(tail->next), sentinel);
+
+        atomic_init(&(sentinel->object), sentinel);
+
+    }
+
+    for (i=0; i<STRIPES; i++){
+
+        pthread_mutex_init(&(hashtable->stripes[i].lock), NULL);
+
+        hashtable->stripes[i].used = 0;
+        hashtable->stripes[i].pending = capacity + i;
+
+    }
+
+    return hashtable;
+
+}
+
+void* concurrentUpsertKey(struct chasht* hashtable, void *key, void* object){
+
+    /*
+        Richiede: struttura hashtable non nulla
+        Effetto: se la chiave è già presente sostituisce l'oggetto associato e restituisce quello
+                    precedente, altrimenti inserisce la coppia chiave-oggetto e restituisce NULL.
+                    Attenzione: l'oggetto precedente può essere ancora in uso da parte di lettori concorrenti.
+    */
+
+    struct stripe *stripe;
+    struct node *start, *node;
+    unsigned int hashedkey, order, size;
+    void *previous;
+    int full;
+
+    assert(hashtable != NULL);
+
+    order = reverse((hashedkey = mix(hashtable->hash(key)))) | 1;
+
+    pthread_mutex_lock(&((stripe = &(hashtable->stripes[hashedkey & (STRIPES - 1)]))->lock));
+
+    // Il numero di bucket può crescere in qualsiasi momento: la sentinella trovata resta comunque
+    // un punto di partenza valido, perchè precede nella lista tutti gli elementi del bucket
+    size = atomic_load_explicit(&(hashtable->size), memory_order_acquire);
+    start = bucketInit(hashtable, hashedkey & (size - 1));
+
+    for (node = atomic_load_explicit(&(start->next), memory_order_relaxed); node != NULL && node->order <= order;
+            node = atomic_load_explicit(&(node->next), memory_order_relaxed)){
+
+        if (node->order == order && node->hash == hashedkey && hashtable->equal(node->key, key)){
+
+            previous = atomic_exchange_explicit(&(node->object), object, memory_order_acq_rel);
+
+            pthread_mutex_unlock(&(stripe->lock));
+
+            return previous;
+
+        }
+
+    }
+
+    node = smalloc(sizeof(struct node));
+    node->order = order;
+    node->hash = hashedkey;
+    node->key = key;
+
+    atomic_init(&(node->object), object);
+
+    listInsert(start, node);
+
+    // Dopo una crescita aggiunge alla lista alcune delle sentinelle mancanti della partizione
+    for (unsigned int i=0; i<SPLITS && stripe->pending < size; i++, stripe->pending += STRIPES) bucketInit(hashtable, stripe->pending);
+
+    // Stima il fattore di carico dalla sola partizione corrente, senza leggere i contatori delle altre
+    full = ++stripe->used > size / STRIPES;
+
+    pthread_mutex_unlock(&(stripe->lock));
+
+    if (full) grow(hashtable, size);
+
+    return NULL;
+
+}
+
+void concurrentDeleteKey(struct chasht *hashtable, void* key){
+
+    struct stripe *stripe;
+    struct node *node, *_Atomic *plist;
+    unsigned int hashedkey, order;
+
+    assert(hashtable != NULL);
+
+    order = reverse((hashedkey = mix(hashtable->hash(key)))) | 1;
+
+    pthread_mutex_lock(&((stripe = &(hashtable->stripes[hashedkey & (STRIPES - 1)]))->lock));
+
+    for (plist = &(bucketStart(hashtable, hashedkey)->next); (node = atomic_load_explicit(plist, memory_order_relaxed)) != NULL && node->order <= order; plist = &(node->next)){
+
+        if (node->order == order && node->hash == hashedkey && hashtable->equal(node->key, key)){
+
+            // Il nodo rimosso mantiene il proprio puntatore al successivo: un lettore fermo su di esso può proseguire
+            atomic_store_explicit(plist, atomic_load_explicit(&(node->next), memory_order_relaxed), memory_order_release);
+
+            stripe->used--;
+
+            pthread_mutex_unlock(&(stripe->lock));
+
+            epochRetire(node, free);
+
+            return;
+
+        }
+
+    }
+
+    pthread_mutex_unlock(&(stripe->lock));
+
+}
+
+unsigned int concurrentSearchKey(struct chasht *hashtable, void* key){
+
+    /*
+        Richiede: struttura hashtable non nulla
+        Effetto: restituisce True se la chiave è presente nella tabella, senza acquisire lock
+    */
+
+    unsigned int found;
+
+    assert(hashtable != NULL);
+
+    epochEnter();
+
+    found = find(hashtable, key, mix(hashtable->hash(key))) != NULL ? TRUE : FALSE;
+
+    epochExit();
+
+    return found;
+
+}
+
+void* concurrentGetObject(struct chasht *hashtable, void *key){
+
+    /*
+        Richiede: struttura hashtable non nulla
+        Effetto: restituisce l'oggetto associato alla chiave oppure NULL, senza acquisire lock
+    */
+
+    struct node *node;
+    void *object = NULL;
+
+    assert(hashtable != NULL);
+
+    epochEnter();
+
+    if ((node = find(hashtable, key, mix(hashtable->hash(key)))) != NULL)
+
+        object = atomic_load_explicit(&(node->object), memory_order_acquire);
+
+    epochExit();
+
+    return object;
+
+}
+
+void destroyConcurrentHashTable(struct chasht* hashtable){
+
+    /*
+        Richiede: struttura hashtable non nulla, nessuna operazione concorrente in corso
+        Effetto: libera i nodi, l'array di bucket e la struttura della tabella.
+                    I nodi rimossi in precedenza vengono liberati dal meccanismo delle epoche.
+                    Attenzione che non libera lo spazio riservato alle chiavi e agli oggetti.
+    */
+
+    struct node *node, *next, *segment;
+
+    assert(hashtable != NULL);
+
+    // La lista contiene anche le sentinelle dei bucket (con chiave di ordinamento pari), che appartengono ai segmenti
+    for (node = atomic_load(&(bucketSlot(hashtable, 0)->next)); node != NULL; node = next){
+
+        next = atomic_load(&(node->next));
+
+        if (node->order & 1) free(node);
+
+    }
+
+    for (unsigned int i=0; i<STRIPES; i++) pthread_mutex_destroy(&(hashtable->stripes[i].lock));
+
+    for (unsigned int i=0; i<SEGMENTS; i++) if ((segment = atomic_load(&(hashtable->segments[i]))) != NULL) free(segment);
+
+    free(hashtable);
+
+}
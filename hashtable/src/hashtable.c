@@ -1,16 +1,59 @@
 #include "../header/hashtable.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
 #include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #define TRUE 1
 #define FALSE 0
 
+// Numero di slot i cui byte di controllo vengono confrontati contemporaneamente (HASHTABLE_OPEN)
+#define GROUP_WIDTH 16
+
+// Byte di controllo degli slot liberi; uno slot occupato contiene invece i 7 bit bassi dell'hash (valore >= 0)
+#define CTRL_EMPTY ((signed char) -128)
+#define CTRL_DELETED ((signed char) -2)
+
+// Scompone l'hash rimescolato nella posizione iniziale di ricerca (H1) e nel byte di controllo (H2)
+#define H1(h) ((h) >> 7)
+#define H2(h) ((signed char) ((h) & 0x7F))
+
+// Numero di bucket (o di gruppi di slot) migrati ad ogni operazione durante un ridimensionamento
+#define REHASH_STEPS 4
+
+// Numero di chiavi di cui getObjectBatch e searchKeyBatch anticipano contemporaneamente il caricamento
+#define BATCH_WIDTH 16
+
+// Impronte per bucket del filtro e numero massimo di spostamenti tentati da un inserimento nel filtro
+#define FILTER_SLOTS 4
+#define FILTER_MAX_KICKS 500
+
+// Intestazione dei file prodotti da saveHashTable
+#define SNAPSHOT_MAGIC "HASHTBL"
+#define SNAPSHOT_VERSION 1
+
+// Numero di nodi del primo blocco allocato e limite oltre il quale i blocchi successivi smettono di raddoppiare
+#define SLAB_MIN_NODES 64
+#define SLAB_MAX_NODES 4096
+
 struct node {
 
     // In caso di collisione punta al nodo successivo (lista di collisione)
     struct node *next;
 
+    // Hash completo (rimescolato) della chiave: scarta i nodi con chiave diversa senza chiamare equal
+    // e permette di spostare il nodo durante un ridimensionamento senza ricalcolare l'hash
+    unsigned int hash;
+
     // Questo valore contiene la chiave originale
     void *key;
 
@@ -19,13 +62,152 @@ struct node {
 
 };
 
+// Blocco contiguo da cui vengono ricavati i nodi delle liste di collisione (HASHTABLE_CHAINED)
+struct slab {
+
+    struct slab *next;
+
+    unsigned int count;
+
+    struct node nodes[];
+
+};
+
+// Slot della modalità ad indirizzamento aperto: chiave e oggetto sono memorizzati direttamente nell'array
+struct slot {
+
+    void *key;
+
+    void *object;
+
+};
+
+// Filtro a cuckoo: ogni bucket contiene FILTER_SLOTS impronte a 16 bit (0 indica uno slot vuoto) e ogni
+// impronta può trovarsi solo in due bucket, per cui una ricerca legge al più due parole da 8 byte
+struct filter {
+
+    uint64_t *buckets;
+
+    // Numero di bucket (potenza di 2) e di impronte contenute
+    unsigned int size, count;
+
+    // Stato del generatore pseudo-casuale che sceglie l'impronta da spostare
+    unsigned int seed;
+
+};
+
+/*
+    Formato dei file prodotti da saveHashTable; tutte le sezioni sono allineate a 8 byte e contengono
+    solo offset relativi, in modo che il file possa essere mappato in memoria a qualsiasi indirizzo:
+
+        struct snapshot                         intestazione
+        uint32_t offsets[buckets + 1]           gli elementi del bucket b sono entries[offsets[b] .. offsets[b+1]-1]
+        struct entry entries[count]             elementi ordinati per bucket
+        heap                                    byte delle chiavi e degli oggetti
+*/
+struct snapshot {
+
+    char magic[8];
+
+    uint32_t version;
+
+    // Numero di bucket, potenza di 2
+    uint32_t buckets;
+
+    // Numero di elementi
+    uint64_t count;
+
+    // Lunghezza totale del file
+    uint64_t length;
+
+    // Checksum di tutto il contenuto che segue l'intestazione
+    uint64_t checksum;
+
+};
+
+struct entry {
+
+    // Hash completo (rimescolato) della chiave
+    uint32_t hash;
+
+    uint32_t keylength, objectlength, reserved;
+
+    // Posizione di chiave e oggetto all'interno dello heap
+    uint64_t key, object;
+
+};
+
+struct table {
+
+    union {
+
+        // Array delle liste di collisione (HASHTABLE_CHAINED)
+        struct node **array;
+
+        // Byte di controllo e slot (HASHTABLE_OPEN); i byte di controllo sono size + GROUP_WIDTH
+        // perchè i primi GROUP_WIDTH vengono replicati in coda per leggere un gruppo a cavallo della fine
+        struct {
+
+            signed char *ctrl;
+
+            struct slot *slots;
+
+        };
+
+    };
+
+    // Numero di bucket o di slot, sempre potenza di 2
+    unsigned int size;
+
+    // Numero di elementi contenuti e di slot marcati come cancellati (HASHTABLE_OPEN)
+    unsigned int used, deleted;
+
+};
+
 typedef struct hasht {
 
+    // Modalità della tabella (HASHTABLE_CHAINED o HASHTABLE_OPEN)
+    int mode;
+
+    // ht[0] è la tabella corrente; durante un ridimensionamento gli elementi vengono
+    // spostati pochi alla volta in ht[1], che al termine prende il posto di ht[0]
+    struct table ht[2];
+
+    // Prossimo bucket (o slot) di ht[0] da migrare, -1 se non è in corso un ridimensionamento
+    long rehashidx;
+
+    // Dimensione iniziale, sotto la quale la tabella non viene ristretta
+    unsigned int minsize;
+
+    // Blocchi di nodi allocati dalla tabella, il primo della lista è quello in uso
+    struct slab *slabs;
+
+    // Numero di nodi del blocco in uso non ancora assegnati
+    unsigned int slabfree;
+
+    // Nodi restituiti da deleteKey, riutilizzati dagli inserimenti successivi
+    struct node *freelist;
+
+    // Filtro opzionale che risponde alla maggior parte delle ricerche di chiavi assenti senza accedere alla tabella
+    struct filter *filter;
+
+    struct hashstats stats;
+
+    // File mappato in memoria (HASHTABLE_MAPPED): le ricerche confrontano i byte della chiave cercata,
+    // ottenuti tramite keybytes, con quelli memorizzati nel file
     struct {
-    
-        struct node **array;
 
-        unsigned int size;
+        void *map;
+
+        size_t maplength;
+
+        const uint32_t *offsets;
+
+        const struct entry *entries;
+
+        const char *heap;
+
+        unsigned int (*keybytes)(void*, const void**);
 
     };
 
@@ -40,12 +222,12 @@ typedef struct hasht {
 
 
 // Define static safe malloc that prevents from memory allocations error
-static void* smalloc(unsigned int size){
+static void* smalloc(size_t size){
 
     void* object = malloc(size);
 
     if (object == NULL) {
-        
+
         fprintf(stderr, "Memory allocation error\n");
 
         exit(0);
@@ -56,174 +238,1424 @@ static void* smalloc(unsigned int size){
 
 }
 
-struct hasht* newHashTable(unsigned int size, unsigned int (*hashcode)(void*), unsigned int (*equal)(void*, void*)){
+// Rimescola i bit dell'hash restituito dalla funzione utente (finalizzatore di murmur3),
+// in modo che sia l'indice ottenuto per mascheramento che H2 dipendano da tutti i bit della chiave
+static inline unsigned int mix(unsigned int h){
 
-    assert(hashcode != NULL);
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
 
-    struct hasht* hashtable = smalloc(sizeof(struct hasht));
-    hashtable->array = smalloc(size * sizeof(struct node*));
-    hashtable->size = size;
-    hashtable->hash = hashcode;
-    hashtable->equal = equal;
+    return h;
+
+}
 
-    // Inizializzo i puntatori dell'array a NULL
-    for (int i=0; i<size; i++) *(hashtable->array + i) = NULL;
+static inline int isRehashing(struct hasht *hashtable){
 
-    return hashtable;
+    return hashtable->rehashidx != -1;
 
 }
 
-void insertKey(struct hasht* hashtable, void *key, void* object){
+// Tabella in cui vanno inseriti i nuovi elementi
+static inline struct table* target(struct hasht *hashtable){
 
-    struct node *plist, *newnode;
-    unsigned int hashedkey;
+    return &(hashtable->ht[isRehashing(hashtable) ? 1 : 0]);
 
-    assert(hashtable != NULL);
-    // Verifica che la funzione hash restituisca un valore intero positivo
-    assert((hashedkey = hashtable->hash(key)) >= 0);
+}
 
-    // Creo un nuovo nodo da inserire nella tabella hash
-    newnode = smalloc(sizeof(struct node));
-    newnode->next = NULL;
-    newnode->key = key;
-    newnode->object = object;
 
-    if (hashtable->array[hashedkey] == NULL)
+/* ------------------------------ Liste di collisione ------------------------------ */
 
-        hashtable->array[hashedkey] = newnode;
+// Restituisce un nodo libero prelevandolo dalla lista dei nodi cancellati oppure dal blocco in uso;
+// i blocchi successivi raddoppiano di dimensione in modo che il numero di malloc sia logaritmico
+static struct node* allocNode(struct hasht *hashtable){
 
-    else {
+    struct node *newnode;
+    struct slab *slab;
+    unsigned int count;
+
+    if ((newnode = hashtable->freelist) != NULL){
+
+        hashtable->freelist = newnode->next;
+
+        return newnode;
+
+    }
+
+    if (hashtable->slabfree == 0){
+
+        count = hashtable->slabs == NULL ? SLAB_MIN_NODES :
+                    hashtable->slabs->count < SLAB_MAX_NODES ? hashtable->slabs->count * 2 : SLAB_MAX_NODES;
 
-        for (plist = hashtable->array[hashedkey]; plist->next != NULL; (plist = plist->next));
+        slab = smalloc(sizeof(struct slab) + count * sizeof(struct node));
+        slab->next = hashtable->slabs;
+        slab->count = count;
+
+        hashtable->slabs = slab;
+        hashtable->slabfree = count;
 
-        plist->next = newnode;
-        
     }
 
+    return &(hashtable->slabs->nodes[hashtable->slabs->count - hashtable->slabfree--]);
+
 }
 
-void deleteKey(struct hasht *hashtable, void* key){
+static void freeNode(struct hasht *hashtable, struct node *node){
+
+    node->next = hashtable->freelist;
+
+    hashtable->freelist = node;
+
+}
+
+// Restituisce il puntatore al campo che punta al nodo con la chiave cercata, NULL se la chiave non è presente
+static struct node** chainFind(struct hasht *hashtable, struct table *table, void *key, unsigned int hashed){
 
-    unsigned int hashedkey;
     struct node **plist, *temp;
 
-    assert(hashtable != NULL);
+    for (plist = &(table->array[hashed & (table->size - 1)]); (temp = *plist) != NULL; plist = &(temp->next))
+
+        if (temp->hash == hashed && hashtable->equal(temp->key, key)) return plist;
+
+    return NULL;
 
-    assert((hashedkey = hashtable->hash(key)) >= 0);
+}
 
-    // Verifica se esiste una lista di collisioni
-    if ((plist = &(hashtable->array[hashedkey])) != NULL){
+static void chainInsert(struct table *table, struct node *newnode){
 
-        do {
+    struct node **plist = &(table->array[newnode->hash & (table->size - 1)]);
 
-            // Cerca se il valore è contenuto nella lista delle collisioni
-            if (hashtable->equal((temp = (*plist))->key, key)){
-                
-                // Sostituisce il nodo da eliminare con il nodo successivo
-                *plist = temp->next;
+    // Aggiunge il nodo in testa alla lista di collisione
+    newnode->next = *plist;
+    *plist = newnode;
 
-                free(temp);
+    table->used++;
 
-                break;
+}
 
-            }
 
-        } while((plist = &(temp->next)) != NULL);
+/* ---------------------------- Indirizzamento aperto ----------------------------- */
+
+// Restituisce una maschera in cui il bit i è attivo se l'i-esimo byte di controllo del gruppo vale c
+static inline unsigned int matchByte(const signed char *group, signed char c){
+
+#ifdef __SSE2__
+
+    __m128i ctrl = _mm_loadu_si128((const __m128i*) group);
+
+    return (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(c), ctrl));
+
+#else
+
+    unsigned int mask = 0;
+
+    for (int i=0; i<GROUP_WIDTH; i++) if (group[i] == c) mask |= 1u << i;
+
+    return mask;
+
+#endif
+
+}
+
+// Restituisce una maschera in cui il bit i è attivo se l'i-esimo slot del gruppo è vuoto o cancellato
+static inline unsigned int matchFree(const signed char *group){
+
+#ifdef __SSE2__
+
+    // Gli slot liberi sono gli unici con il bit di segno attivo
+    return (unsigned int) _mm_movemask_epi8(_mm_loadu_si128((const __m128i*) group));
+
+#else
+
+    unsigned int mask = 0;
+
+    for (int i=0; i<GROUP_WIDTH; i++) if (group[i] < 0) mask |= 1u << i;
+
+    return mask;
+
+#endif
+
+}
+
+static inline void setCtrl(struct table *table, unsigned int i, signed char c){
+
+    table->ctrl[i] = c;
+
+    // Mantiene allineata la copia in coda dei primi GROUP_WIDTH byte di controllo
+    if (i < GROUP_WIDTH) table->ctrl[table->size + i] = c;
+
+}
+
+// Restituisce l'indice dello slot che contiene la chiave oppure -1 se la chiave non è presente.
+// La sequenza di ricerca visita gruppi di GROUP_WIDTH slot a distanze triangolari, che con
+// size potenza di 2 coprono l'intero array; la ricerca termina al primo gruppo con uno slot vuoto.
+// Se freeslot non è NULL vi scrive il primo slot libero incontrato, in cui inserire la chiave se assente
+static long openFind(struct hasht *hashtable, struct table *table, void *key, unsigned int hashed, long *freeslot){
+
+    unsigned int mask = table->size - 1, pos = H1(hashed) & mask, step = 0, match;
+    signed char h2 = H2(hashed);
+    const signed char *group;
+
+    if (freeslot != NULL) *freeslot = -1;
+
+    for (;;) {
+
+        group = table->ctrl + pos;
+
+        for (match = matchByte(group, h2); match != 0; match &= match - 1) {
+
+            unsigned int i = (pos + __builtin_ctz(match)) & mask;
+
+            if (hashtable->equal(table->slots[i].key, key)) return i;
+
+        }
+
+        if (freeslot != NULL && *freeslot < 0 && (match = matchFree(group)) != 0)
+
+            *freeslot = (pos + __builtin_ctz(match)) & mask;
+
+        if (matchByte(group, CTRL_EMPTY) != 0) return -1;
+
+        step += GROUP_WIDTH;
+        pos = (pos + step) & mask;
 
     }
 
 }
 
-unsigned int searchKey(struct hasht *hashtable, void* key){
+// Memorizza la coppia chiave-oggetto nello slot libero i
+static void openPlace(struct table *table, unsigned int i, void *key, void *object, unsigned int hashed){
 
-    /*
-        Richiede: struttura hashtable non nulla && funzione hash che restituisce un valore intero >= 0
-        Effetto: restituisce True se vi è un nodo contenuto nella hashtable la cui chiave
-                    corrisponde alla chiave passata come parametro
-                    Nota che la chiave può essere di qualsiasi tipo, verrà confrontata
-                    tra le chiavi presenti nei nodi attraverso la funzione equal definita
-                    nella struct hasht
-    */
+    if (table->ctrl[i] == CTRL_DELETED) table->deleted--;
 
-    struct node *plist;
-    unsigned int hashedkey;
+    setCtrl(table, i, H2(hashed));
+    table->slots[i] = (struct slot) { .key=key, .object=object };
+    table->used++;
 
-    assert(hashtable != NULL);
+}
 
-    assert((hashedkey = hashtable->hash(key)) >= 0);
+// Occupa il primo slot libero (vuoto o cancellato) lungo la sequenza di ricerca
+static void openInsert(struct table *table, void *key, void *object, unsigned int hashed){
 
-    if ((plist = *(hashtable->array + hashedkey)) != NULL){
+    unsigned int mask = table->size - 1, pos = H1(hashed) & mask, step = 0, match;
 
-        do{
-            
-            if (hashtable->equal(plist->key,key))
+    while ((match = matchFree(table->ctrl + pos)) == 0) {
 
-                return TRUE;
+        step += GROUP_WIDTH;
+        pos = (pos + step) & mask;
+
+    }
+
+    openPlace(table, (pos + __builtin_ctz(match)) & mask, key, object, hashed);
+
+}
+
+static void openRemove(struct table *table, unsigned int i){
+
+    // Lo slot non può tornare vuoto perchè interromperebbe le sequenze di ricerca che lo attraversano
+    setCtrl(table, i, CTRL_DELETED);
+
+    table->used--;
+    table->deleted++;
+
+}
+
+// Vero se la tabella può ricevere un ulteriore elemento mantenendo gli slot non vuoti sotto i 7/8,
+// condizione che garantisce che ogni sequenza di ricerca incontri un gruppo con uno slot vuoto
+static inline int openHasRoom(struct table *table){
+
+    return (table->used + table->deleted + 1) * 8 <= table->size * 7;
+
+}
+
+
+/* ------------------------------- Ridimensionamento ------------------------------- */
+
+static void tableAlloc(struct hasht *hashtable, struct table *table, unsigned int size){
+
+    size_t length = size;
+
+    // Gli array della tabella devono essere rappresentabili in size_t (rilevante con size_t a 32 bit)
+    if (length > (SIZE_MAX - GROUP_WIDTH) / sizeof(struct slot) || length > SIZE_MAX / sizeof(struct node*)){
+
+        fprintf(stderr, "Memory allocation error\n");
 
-        } while((plist = plist->next) != NULL);
+        exit(0);
 
     }
 
-    return FALSE;
+    table->size = size;
+    table->used = 0;
+    table->deleted = 0;
+
+    if (hashtable->mode == HASHTABLE_OPEN){
+
+        table->ctrl = smalloc(length + GROUP_WIDTH);
+        table->slots = smalloc(length * sizeof(struct slot));
+
+        memset(table->ctrl, CTRL_EMPTY, length + GROUP_WIDTH);
+
+    }
+
+    else {
+
+        table->array = smalloc(length * sizeof(struct node*));
+
+        // Inizializzo i puntatori dell'array a NULL
+        for (unsigned int i=0; i<size; i++) *(table->array + i) = NULL;
+
+    }
 
 }
 
-void* getObject(struct hasht *hashtable, void *key){
+// Libera l'array della tabella; i nodi delle liste di collisione appartengono ai blocchi della hashtable
+static void tableFree(struct hasht *hashtable, struct table *table){
 
-    /*
-        Richiede: struttura hashtable non nulla && funzione hash che restituisce un valore intero >= 0
-        Effetto: restituisce l'oggetto contenuto nel nodo la cui chiave
-                    corrisponde alla chiave passata come parametro
-                    Nota che la chiave può essere di qualsiasi tipo, verrà confrontata
-                    tra le chiavi presenti nei nodi attraverso la funzione equal definita
-                    nella struct hasht
-    */
+    if (hashtable->mode == HASHTABLE_OPEN){
 
+        free(table->ctrl);
+        free(table->slots);
 
-    struct node *plist;
-    unsigned int hashedkey;
+    }
 
-    assert(hashtable != NULL);
+    else free(table->array);
 
-    assert((hashedkey = hashtable->hash(key)) >= 0);
+}
+
+// Avvia la migrazione degli elementi verso una nuova tabella di size bucket (o slot)
+static void startResize(struct hasht *hashtable, unsigned int size){
+
+    tableAlloc(hashtable, &(hashtable->ht[1]), size);
+
+    hashtable->rehashidx = 0;
+
+}
+
+// Sposta in ht[1] al più REHASH_STEPS bucket (o gruppi di slot) di ht[0], in modo che il costo di un
+// ridimensionamento venga distribuito sulle operazioni successive; quando ht[0] è vuota la sostituisce con ht[1]
+static void rehashStep(struct hasht *hashtable){
+
+    struct table *from = &(hashtable->ht[0]), *to = &(hashtable->ht[1]);
+    struct node *temp, *n;
+    unsigned int i, limit, empty_visits = REHASH_STEPS * 10, steps = REHASH_STEPS;
 
-    if ((plist = *(hashtable->array + hashedkey)) != NULL){
+    if (!isRehashing(hashtable)) return;
 
-        do{
-            
-            if (hashtable->equal(plist->key,key))
+    if (hashtable->mode == HASHTABLE_OPEN){
 
-                return plist->object;
+        limit = hashtable->rehashidx + REHASH_STEPS * GROUP_WIDTH;
 
-        } while((plist = plist->next) != NULL);
+        for (i = hashtable->rehashidx; i < limit && i < from->size && from->used > 0; i++){
+
+            if (from->ctrl[i] >= 0){
+
+                openInsert(to, from->slots[i].key, from->slots[i].object, mix(hashtable->hash(from->slots[i].key)));
+                openRemove(from, i);
+
+            }
+
+        }
+
+        hashtable->rehashidx = i;
 
     }
 
-    return NULL;
+    else {
+
+        while (steps-- > 0 && from->used > 0){
+
+            // Limita anche il numero di bucket vuoti visitati in una singola operazione
+            while (from->array[hashtable->rehashidx] == NULL){
+
+                hashtable->rehashidx++;
+
+                if (--empty_visits == 0) return;
+
+            }
+
+            for (temp = from->array[hashtable->rehashidx]; temp != NULL; temp = n){
+
+                n = temp->next;
+
+                chainInsert(to, temp);
+                from->used--;
+
+            }
+
+            from->array[hashtable->rehashidx++] = NULL;
+
+        }
+
+    }
+
+    if (from->used == 0){
+
+        tableFree(hashtable, from);
+
+        hashtable->ht[0] = *to;
+        hashtable->rehashidx = -1;
+
+        memset(to, 0, sizeof(struct table));
+
+    }
 
 }
 
-void destroyHashTable(struct hasht* hashtable){
+// Completa immediatamente un eventuale ridimensionamento in corso
+static void rehashAll(struct hasht *hashtable){
 
-    /*
-        Richiede: struttura hashtable non nulla
-        Effetto: libera lo spazio allocato per ciascun nodo e lo spazio riservato
-                    a contenere la struttura della tabella stessa.
-                    Attenzione che non libera lo spazio riservato alla chiave e all'oggetto
-                    contenuti in ciascun nodo.
-    */
+    while (isRehashing(hashtable)) rehashStep(hashtable);
 
-    struct node **nnode, *temp, *n;
-    int counter;
+}
 
-    assert(hashtable != NULL);
+// Dopo un inserimento: raddoppia le liste di collisione quando il fattore di carico raggiunge 1
+static void checkGrow(struct hasht *hashtable){
 
-    for (nnode=hashtable->array, counter=0; counter++ < hashtable->size; nnode = (nnode + 1))
+    struct table *table = &(hashtable->ht[0]);
 
-        for (temp=*nnode, n=temp; temp != NULL && (n = n->next) != NULL; temp=n)
+    if (!isRehashing(hashtable) && hashtable->mode == HASHTABLE_CHAINED && table->used >= table->size)
 
-            free(temp);
+        startResize(hashtable, table->size * 2);
 
-    free(hashtable);
+}
+
+// Prima di un inserimento ad indirizzamento aperto: garantisce che la tabella di destinazione abbia spazio
+static void checkRoom(struct hasht *hashtable){
+
+    struct table *table;
+
+    // ht[1] è dimensionata per contenere ht[0] e tutti gli inserimenti che avvengono durante la migrazione;
+    // se per via di molte cancellazioni rimane senza spazio la migrazione viene completata subito
+    if (isRehashing(hashtable) && !openHasRoom(&(hashtable->ht[1]))) rehashAll(hashtable);
+
+    if (!isRehashing(hashtable) && !openHasRoom((table = &(hashtable->ht[0]))))
+
+        // Se la maggior parte degli slot non disponibili è cancellata ricostruisce la tabella con la stessa dimensione
+        startResize(hashtable, (table->used + 1) * 16 > table->size * 7 ? table->size * 2 : table->size);
+
+}
+
+// Dopo una cancellazione: dimezza la tabella quando è occupata per meno di 1/8
+static void checkShrink(struct hasht *hashtable){
+
+    struct table *table = &(hashtable->ht[0]);
+
+    if (!isRehashing(hashtable) && table->size > hashtable->minsize && table->used * 8 < table->size)
+
+        startResize(hashtable, table->size / 2);
+
+}
+
+
+/* ------------------------------------- Filtro ------------------------------------- */
+
+#define LANES(x) ((x) * 0x0001000100010001ULL)
+
+// Impronta a 16 bit non nulla, ricavata da un secondo rimescolamento così da essere indipendente dal bucket
+static inline uint64_t fingerprint(unsigned int hashed){
+
+    unsigned int f = mix(hashed ^ 0x9e3779b9) >> 16;
+
+    return f != 0 ? f : 1;
+
+}
+
+// Bucket alternativo di un'impronta: l'operazione è un'involuzione, quindi si può calcolare da entrambi i bucket
+static inline unsigned int altBucket(struct filter *filter, unsigned int bucket, uint64_t f){
+
+    return (bucket ^ mix((unsigned int) f)) & (filter->size - 1);
+
+}
+
+// Vero se una delle quattro impronte del bucket vale f (confronto parallelo sui 4 campi a 16 bit della parola)
+static inline int bucketHas(uint64_t bucket, uint64_t f){
+
+    uint64_t v = bucket ^ LANES(f);
+
+    return ((v - LANES(1)) & ~v & LANES(0x8000)) != 0;
+
+}
+
+static inline int bucketPut(uint64_t *bucket, uint64_t f){
+
+    for (int i=0; i<FILTER_SLOTS; i++){
+
+        if (((*bucket >> (16 * i)) & 0xFFFF) == 0){
+
+            *bucket |= f << (16 * i);
+
+            return TRUE;
+
+        }
+
+    }
+
+    return FALSE;
+
+}
+
+static int filterContains(struct filter *filter, unsigned int hashed){
+
+    uint64_t f = fingerprint(hashed);
+    unsigned int i1 = hashed & (filter->size - 1);
+
+    return bucketHas(filter->buckets[i1], f) || bucketHas(filter->buckets[altBucket(filter, i1, f)], f);
+
+}
+
+// Inserisce l'impronta spostando all'occorrenza quelle già presenti nel loro bucket alternativo.
+// Se dopo FILTER_MAX_KICKS spostamenti non trova posto restituisce False: l'ultima impronta spostata
+// è andata persa e il filtro va ricostruito a partire dal contenuto della tabella
+static int filterAdd(struct filter *filter, unsigned int hashed){
+
+    uint64_t f = fingerprint(hashed), victim;
+    unsigned int i = hashed & (filter->size - 1), slot;
+
+    if (bucketPut(&(filter->buckets[i]), f) || bucketPut(&(filter->buckets[(i = altBucket(filter, i, f))]), f)){
+
+        filter->count++;
+
+        return TRUE;
+
+    }
+
+    for (int kicks = 0; kicks < FILTER_MAX_KICKS; kicks++){
+
+        filter->seed = filter->seed * 1103515245 + 12345;
+        slot = (filter->seed >> 16) % FILTER_SLOTS;
+
+        // Scambia l'impronta corrente con quella contenuta nello slot scelto
+        victim = (filter->buckets[i] >> (16 * slot)) & 0xFFFF;
+        filter->buckets[i] ^= (victim ^ f) << (16 * slot);
+        f = victim;
+
+        if (bucketPut(&(filter->buckets[(i = altBucket(filter, i, f))]), f)){
+
+            filter->count++;
+
+            return TRUE;
+
+        }
+
+    }
+
+    return FALSE;
+
+}
+
+static void filterRemove(struct filter *filter, unsigned int hashed){
+
+    uint64_t f = fingerprint(hashed);
+    unsigned int i = hashed & (filter->size - 1);
+
+    for (int b = 0; b < 2; b++, i = altBucket(filter, i, f)){
+
+        for (int slot = 0; slot < FILTER_SLOTS; slot++){
+
+            if (((filter->buckets[i] >> (16 * slot)) & 0xFFFF) == f){
+
+                filter->buckets[i] &= ~(0xFFFFULL << (16 * slot));
+                filter->count--;
+
+                return;
+
+            }
+
+        }
+
+    }
+
+}
+
+// Ricostruisce il filtro con size bucket a partire dagli elementi della tabella. Se un'impronta non trova
+// posto (accade solo con molte copie della stessa chiave) il filtro viene disattivato
+static void filterRebuild(struct hasht *hashtable, unsigned int size){
+
+    struct filter *filter = hashtable->filter;
+    struct table *table;
+    struct node *node;
+    unsigned int b;
+    int t, ok = TRUE;
+
+    free(filter->buckets);
+
+    filter->buckets = smalloc(size * sizeof(uint64_t));
+    filter->size = size;
+    filter->count = 0;
+
+    memset(filter->buckets, 0, size * sizeof(uint64_t));
+
+    for (t = 0; ok && t <= (isRehashing(hashtable) ? 1 : 0); t++){
+
+        table = &(hashtable->ht[t]);
+
+        for (b = 0; ok && b < table->size; b++){
+
+            if (hashtable->mode == HASHTABLE_OPEN){
+
+                if (table->ctrl[b] >= 0) ok = filterAdd(filter, mix(hashtable->hash(table->slots[b].key)));
+
+            }
+
+            else for (node = table->array[b]; ok && node != NULL; node = node->next) ok = filterAdd(filter, node->hash);
+
+        }
+
+    }
+
+    if (!ok){
+
+        free(filter->buckets);
+        free(filter);
+
+        hashtable->filter = NULL;
+
+    }
+
+}
+
+// Aggiunge al filtro un elemento appena inserito nella tabella, raddoppiando il filtro quando
+// supera il 90% di occupazione oppure quando l'impronta non trova posto
+static void filterInsert(struct hasht *hashtable, unsigned int hashed){
+
+    struct filter *filter = hashtable->filter;
+
+    if ((filter->count + 1) * 10 > filter->size * FILTER_SLOTS * 9 || !filterAdd(filter, hashed))
+
+        filterRebuild(hashtable, filter->size * 2);
+
+}
+
+// Interroga il filtro, se presente: restituisce False se la chiave è certamente assente
+static int filterPass(struct hasht *hashtable, unsigned int hashed){
+
+    if (hashtable->filter == NULL) return TRUE;
+
+    hashtable->stats.queries++;
+
+    if (filterContains(hashtable->filter, hashed)) return TRUE;
+
+    hashtable->stats.filtered++;
+
+    return FALSE;
+
+}
+
+
+/* ------------------------------------ Ricerca ------------------------------------ */
+
+// Ricerca nel file mappato: restituisce il puntatore ai byte dell'oggetto, NULL se la chiave non è presente
+static const struct entry* mappedFind(struct hasht *hashtable, void *key, unsigned int hashed){
+
+    const struct entry *entry, *last;
+    const void *bytes;
+    unsigned int length, bucket = hashed & (hashtable->ht[0].size - 1);
+
+    length = hashtable->keybytes(key, &bytes);
+
+    for (entry = hashtable->entries + hashtable->offsets[bucket], last = hashtable->entries + hashtable->offsets[bucket + 1]; entry < last; entry++)
+
+        if (entry->hash == hashed && entry->keylength == length && memcmp(hashtable->heap + entry->key, bytes, length) == 0)
+
+            return entry;
+
+    return NULL;
+
+}
+
+// Restituisce True se la chiave è presente e in tal caso scrive in object l'oggetto associato;
+// durante un ridimensionamento la chiave può trovarsi in una qualsiasi delle due tabelle
+static int lookup(struct hasht *hashtable, void *key, unsigned int hashed, void **object){
+
+    const struct entry *entry;
+    struct node **plist;
+    long i;
+    int t;
+
+    if (hashtable->mode == HASHTABLE_MAPPED){
+
+        if ((entry = mappedFind(hashtable, key, hashed)) == NULL) return FALSE;
+
+        *object = (void*) (hashtable->heap + entry->object);
+
+        return TRUE;
+
+    }
+
+    for (t = 0; t <= (isRehashing(hashtable) ? 1 : 0); t++){
+
+        if (hashtable->mode == HASHTABLE_OPEN){
+
+            if ((i = openFind(hashtable, &(hashtable->ht[t]), key, hashed, NULL)) >= 0){
+
+                *object = hashtable->ht[t].slots[i].object;
+
+                return TRUE;
+
+            }
+
+        }
+
+        else if ((plist = chainFind(hashtable, &(hashtable->ht[t]), key, hashed)) != NULL){
+
+            *object = (*plist)->object;
+
+            return TRUE;
+
+        }
+
+    }
+
+    return FALSE;
+
+}
+
+// Ricerca di una chiave che il filtro ha lasciato passare: se è assente si tratta di un falso positivo
+static int confirm(struct hasht *hashtable, void *key, unsigned int hashed, void **object){
+
+    if (lookup(hashtable, key, hashed, object)) return TRUE;
+
+    if (hashtable->filter != NULL) hashtable->stats.falsepositives++;
+
+    return FALSE;
+
+}
+
+static int probe(struct hasht *hashtable, void *key, unsigned int hashed, void **object){
+
+    return filterPass(hashtable, hashed) && confirm(hashtable, key, hashed, object);
+
+}
+
+// Risolve fino a BATCH_WIDTH chiavi in tre passate: calcola tutti gli hash e anticipa il caricamento
+// dei bucket (o dei gruppi di controllo), poi anticipa quello dei primi nodi (o slot candidati) e solo alla
+// fine percorre le liste; in questo modo i mancati accessi in cache delle diverse chiavi si sovrappongono
+static void lookupBatch(struct hasht *hashtable, void **keys, unsigned int n, void **objects, unsigned int *found){
+
+    struct table *table = &(hashtable->ht[0]);
+    unsigned int hashed[BATCH_WIDTH], mask = table->size - 1, pos, match, j;
+    int passed[BATCH_WIDTH];
+
+    for (j = 0; j < n; j++){
+
+        hashed[j] = mix(hashtable->hash(keys[j]));
+
+        // Le chiavi scartate dal filtro non richiedono alcun accesso alla tabella
+        if (!(passed[j] = filterPass(hashtable, hashed[j]))) continue;
+
+        if (hashtable->mode == HASHTABLE_OPEN)
+
+            __builtin_prefetch(table->ctrl + (H1(hashed[j]) & mask));
+
+        else if (hashtable->mode == HASHTABLE_MAPPED)
+
+            __builtin_prefetch(hashtable->offsets + (hashed[j] & mask));
+
+        else
+
+            __builtin_prefetch(&(table->array[hashed[j] & mask]));
+
+    }
+
+    for (j = 0; j < n; j++){
+
+        if (!passed[j]) continue;
+
+        if (hashtable->mode == HASHTABLE_MAPPED)
+
+            __builtin_prefetch(hashtable->entries + hashtable->offsets[hashed[j] & mask]);
+
+        else if (hashtable->mode == HASHTABLE_OPEN){
+
+            pos = H1(hashed[j]) & mask;
+
+            if ((match = matchByte(table->ctrl + pos, H2(hashed[j]))) != 0)
+
+                __builtin_prefetch(&(table->slots[(pos + __builtin_ctz(match)) & mask]));
+
+        }
+
+        else if (table->array[hashed[j] & mask] != NULL)
+
+            __builtin_prefetch(table->array[hashed[j] & mask]);
+
+    }
+
+    for (j = 0; j < n; j++) if (!(found[j] = passed[j] && confirm(hashtable, keys[j], hashed[j], &(objects[j])))) objects[j] = NULL;
+
+}
+
+
+/* ---------------------------------- Interfaccia ---------------------------------- */
+
+struct hasht* newHashTable(unsigned int size, unsigned int (*hashcode)(void*), unsigned int (*equal)(void*, void*)){
+
+    return newHashTableMode(size, hashcode, equal, HASHTABLE_CHAINED);
+
+}
+
+struct hasht* newHashTableMode(unsigned int size, unsigned int (*hashcode)(void*), unsigned int (*equal)(void*, void*), int mode){
+
+    /*
+        Richiede: funzione hash non nulla, modalità HASHTABLE_CHAINED o HASHTABLE_OPEN
+        Effetto: crea una tabella hash vuota con almeno size bucket (HASHTABLE_CHAINED) o slot
+                    (HASHTABLE_OPEN), arrotondati alla potenza di 2 successiva.
+                    La funzione hash può restituire un qualsiasi valore a 32 bit: la tabella lo riduce
+                    internamente alla propria dimensione, che cresce e si restringe in base al fattore
+                    di carico spostando gli elementi pochi alla volta ad ogni operazione.
+                    HASHTABLE_OPEN memorizza chiavi e oggetti direttamente in un array di slot
+                    (nessuna allocazione per inserimento).
+    */
+
+    unsigned int capacity;
+
+    assert(hashcode != NULL);
+    assert(mode == HASHTABLE_CHAINED || mode == HASHTABLE_OPEN);
+
+    struct hasht* hashtable = smalloc(sizeof(struct hasht));
+    hashtable->mode = mode;
+    hashtable->hash = hashcode;
+    hashtable->equal = equal;
+    hashtable->rehashidx = -1;
+    hashtable->slabs = NULL;
+    hashtable->slabfree = 0;
+    hashtable->freelist = NULL;
+    hashtable->filter = NULL;
+
+    memset(&(hashtable->stats), 0, sizeof(struct hashstats));
+
+    for (capacity = (mode == HASHTABLE_OPEN ? GROUP_WIDTH : 1); capacity < size; capacity <<= 1);
+
+    tableAlloc(hashtable, &(hashtable->ht[0]), (hashtable->minsize = capacity));
+    memset(&(hashtable->ht[1]), 0, sizeof(struct table));
+
+    return hashtable;
+
+}
+
+void insertKey(struct hasht* hashtable, void *key, void* object){
+
+    struct node *newnode;
+    unsigned int hashedkey;
+
+    assert(hashtable != NULL);
+    // Una tabella mappata da file è in sola lettura
+    assert(hashtable->mode != HASHTABLE_MAPPED);
+
+    rehashStep(hashtable);
+
+    hashedkey = mix(hashtable->hash(key));
+
+    if (hashtable->mode == HASHTABLE_OPEN) {
+
+        checkRoom(hashtable);
+
+        openInsert(target(hashtable), key, object, hashedkey);
+
+    }
+
+    else {
+
+        // Creo un nuovo nodo da inserire nella tabella hash
+        newnode = allocNode(hashtable);
+        newnode->hash = hashedkey;
+        newnode->key = key;
+        newnode->object = object;
+
+        chainInsert(target(hashtable), newnode);
+
+        checkGrow(hashtable);
+
+    }
+
+    if (hashtable->filter != NULL) filterInsert(hashtable, hashedkey);
+
+}
+
+void* upsertKey(struct hasht* hashtable, void *key, void* object){
+
+    /*
+        Richiede: struttura hashtable non nulla
+        Effetto: se la chiave è già presente sostituisce l'oggetto associato e restituisce quello
+                    precedente, altrimenti inserisce la coppia chiave-oggetto e restituisce NULL.
+                    A differenza di insertKey non crea mai duplicati della stessa chiave.
+    */
+
+    struct node **plist, *newnode;
+    struct table *table;
+    unsigned int hashedkey;
+    void *previous;
+    long i, freeslot;
+
+    assert(hashtable != NULL);
+    // Una tabella mappata da file è in sola lettura
+    assert(hashtable->mode != HASHTABLE_MAPPED);
+
+    rehashStep(hashtable);
+
+    hashedkey = mix(hashtable->hash(key));
+
+    if (hashtable->mode == HASHTABLE_OPEN){
+
+        checkRoom(hashtable);
+
+        // Durante un ridimensionamento la chiave può trovarsi ancora nella tabella da migrare
+        if (isRehashing(hashtable) && (i = openFind(hashtable, (table = &(hashtable->ht[0])), key, hashedkey, NULL)) >= 0){
+
+            previous = table->slots[i].object;
+            table->slots[i].object = object;
+
+            return previous;
+
+        }
+
+        // Un'unica sequenza di ricerca individua la chiave oppure lo slot libero in cui inserirla
+        if ((i = openFind(hashtable, (table = target(hashtable)), key, hashedkey, &freeslot)) >= 0){
+
+            previous = table->slots[i].object;
+            table->slots[i].object = object;
+
+            return previous;
+
+        }
+
+        openPlace(table, freeslot, key, object, hashedkey);
+
+        if (hashtable->filter != NULL) filterInsert(hashtable, hashedkey);
+
+        return NULL;
+
+    }
+
+    for (i = 0; i <= (isRehashing(hashtable) ? 1 : 0); i++){
+
+        if ((plist = chainFind(hashtable, &(hashtable->ht[i]), key, hashedkey)) != NULL){
+
+            previous = (*plist)->object;
+            (*plist)->object = object;
+
+            return previous;
+
+        }
+
+    }
+
+    newnode = allocNode(hashtable);
+    newnode->hash = hashedkey;
+    newnode->key = key;
+    newnode->object = object;
+
+    chainInsert(target(hashtable), newnode);
+
+    checkGrow(hashtable);
+
+    if (hashtable->filter != NULL) filterInsert(hashtable, hashedkey);
+
+    return NULL;
+
+}
+
+void deleteKey(struct hasht *hashtable, void* key){
+
+    unsigned int hashedkey;
+    struct node **plist, *temp;
+    struct table *table;
+    long i;
+    int t;
+
+    assert(hashtable != NULL);
+    // Una tabella mappata da file è in sola lettura
+    assert(hashtable->mode != HASHTABLE_MAPPED);
+
+    rehashStep(hashtable);
+
+    hashedkey = mix(hashtable->hash(key));
+
+    // Durante un ridimensionamento la chiave può trovarsi in una qualsiasi delle due tabelle
+    for (t = 0; t <= (isRehashing(hashtable) ? 1 : 0); t++){
+
+        table = &(hashtable->ht[t]);
+
+        if (hashtable->mode == HASHTABLE_OPEN){
+
+            if ((i = openFind(hashtable, table, key, hashedkey, NULL)) < 0) continue;
+
+            openRemove(table, i);
+
+        }
+
+        else {
+
+            if ((plist = chainFind(hashtable, table, key, hashedkey)) == NULL) continue;
+
+            // Sostituisce il nodo da eliminare con il nodo successivo
+            *plist = (temp = *plist)->next;
+
+            freeNode(hashtable, temp);
+
+            table->used--;
+
+        }
+
+        if (hashtable->filter != NULL) filterRemove(hashtable->filter, hashedkey);
+
+        checkShrink(hashtable);
+
+        break;
+
+    }
+
+}
+
+unsigned int searchKey(struct hasht *hashtable, void* key){
+
+    /*
+        Richiede: struttura hashtable non nulla
+        Effetto: restituisce True se vi è un nodo contenuto nella hashtable la cui chiave
+                    corrisponde alla chiave passata come parametro
+                    Nota che la chiave può essere di qualsiasi tipo, verrà confrontata
+                    tra le chiavi presenti nei nodi attraverso la funzione equal definita
+                    nella struct hasht
+    */
+
+    assert(hashtable != NULL);
+
+    rehashStep(hashtable);
+
+    void *object;
+
+    return probe(hashtable, key, mix(hashtable->hash(key)), &object);
+
+}
+
+void* getObject(struct hasht *hashtable, void *key){
+
+    /*
+        Richiede: struttura hashtable non nulla
+        Effetto: restituisce l'oggetto contenuto nel nodo la cui chiave
+                    corrisponde alla chiave passata come parametro
+                    Nota che la chiave può essere di qualsiasi tipo, verrà confrontata
+                    tra le chiavi presenti nei nodi attraverso la funzione equal definita
+                    nella struct hasht
+    */
+
+    void *object;
+
+    assert(hashtable != NULL);
+
+    rehashStep(hashtable);
+
+    return probe(hashtable, key, mix(hashtable->hash(key)), &object) ? object : NULL;
+
+}
+
+void getObjectBatch(struct hasht *hashtable, void **keys, unsigned int n, void **out){
+
+    /*
+        Richiede: struttura hashtable non nulla, array keys e out di almeno n elementi
+        Effetto: per ogni i < n scrive in out[i] l'oggetto associato a keys[i] (NULL se assente),
+                    come n chiamate a getObject ma risolvendo le chiavi a gruppi di BATCH_WIDTH
+                    in modo che le attese sulla memoria delle diverse chiavi si sovrappongano.
+    */
+
+    unsigned int found[BATCH_WIDTH], i, m;
+
+    assert(hashtable != NULL);
+
+    rehashStep(hashtable);
+
+    for (i = 0; i < n; i += m)
+
+        lookupBatch(hashtable, keys + i, (m = n - i < BATCH_WIDTH ? n - i : BATCH_WIDTH), out + i, found);
+
+
+}
+
+void searchKeyBatch(struct hasht *hashtable, void **keys, unsigned int n, unsigned int *out){
+
+    /*
+        Richiede: struttura hashtable non nulla, array keys e out di almeno n elementi
+        Effetto: per ogni i < n scrive in out[i] True se keys[i] è presente nella tabella (vedi getObjectBatch)
+    */
+
+    void *objects[BATCH_WIDTH];
+    unsigned int i, m;
+
+    assert(hashtable != NULL);
+
+    rehashStep(hashtable);
+
+    for (i = 0; i < n; i += m)
+
+        lookupBatch(hashtable, keys + i, (m = n - i < BATCH_WIDTH ? n - i : BATCH_WIDTH), objects, out + i);
+
+
+}
+
+void destroyHashTable(struct hasht* hashtable){
+
+    /*
+        Richiede: struttura hashtable non nulla
+        Effetto: libera lo spazio allocato per ciascun nodo e lo spazio riservato
+                    a contenere la struttura della tabella stessa.
+                    I nodi vengono rilasciati un blocco alla volta e non singolarmente.
+                    Attenzione che non libera lo spazio riservato alla chiave e all'oggetto
+                    contenuti in ciascun nodo.
+    */
+
+    struct slab *slab, *next;
+
+    assert(hashtable != NULL);
+
+    if (hashtable->mode == HASHTABLE_MAPPED){
+
+        munmap(hashtable->map, hashtable->maplength);
+
+        free(hashtable);
+
+        return;
+
+    }
+
+    for (slab = hashtable->slabs; slab != NULL; slab = next){
+
+        next = slab->next;
+
+        free(slab);
+
+    }
+
+    tableFree(hashtable, &(hashtable->ht[0]));
+
+    if (isRehashing(hashtable)) tableFree(hashtable, &(hashtable->ht[1]));
+
+    if (hashtable->filter != NULL){
+
+        free(hashtable->filter->buckets);
+        free(hashtable->filter);
+
+    }
+
+    free(hashtable);
+
+}
+
+void enableFilter(struct hasht *hashtable){
+
+    /*
+        Richiede: struttura hashtable non nulla, non mappata da file
+        Effetto: associa alla tabella un filtro a cuckoo costruito a partire dagli elementi presenti.
+                    Da questo momento inserimenti e cancellazioni lo mantengono aggiornato e searchKey,
+                    getObject e le relative versioni batch lo interrogano prima della tabella: la maggior
+                    parte delle chiavi assenti viene scartata leggendo al più due parole del filtro.
+                    Il filtro occupa da 2 a 5 byte per elemento e sbaglia (falso positivo) in meno di
+                    un caso su 8000; se la tabella contiene molte copie della stessa chiave inserite
+                    con insertKey il filtro si disattiva.
+    */
+
+    unsigned int size, count;
+
+    assert(hashtable != NULL);
+    assert(hashtable->mode != HASHTABLE_MAPPED);
+
+    if (hashtable->filter != NULL) return;
+
+    count = hashtable->ht[0].used + (isRehashing(hashtable) ? hashtable->ht[1].used : 0);
+
+    // Dimensiona il filtro per un'occupazione iniziale non superiore al 50%
+    for (size = 1; size * FILTER_SLOTS < count * 2; size <<= 1);
+
+    hashtable->filter = smalloc(sizeof(struct filter));
+    hashtable->filter->buckets = NULL;
+    hashtable->filter->seed = 1;
+
+    filterRebuild(hashtable, size);
+
+}
+
+void hashTableStats(struct hasht *hashtable, struct hashstats *stats){
+
+    /*
+        Richiede: struttura hashtable e struttura stats non nulle
+        Effetto: scrive in stats le statistiche del filtro raccolte da enableFilter in poi
+                    e il tasso di falsi positivi osservato sulle ricerche di chiavi assenti.
+    */
+
+    assert(hashtable != NULL && stats != NULL);
+
+    *stats = hashtable->stats;
+
+    stats->fprate = stats->filtered + stats->falsepositives > 0 ?
+                        (double) stats->falsepositives / (stats->filtered + stats->falsepositives) : 0;
+
+    stats->filterbytes = hashtable->filter != NULL ? hashtable->filter->size * sizeof(uint64_t) : 0;
+
+}
+
+
+/* -------------------------------- Snapshot su file -------------------------------- */
+
+#define CHECKSUM_SEED 0xcbf29ce484222325ULL
+#define ALIGN8(n) (((n) + 7) & ~((uint64_t) 7))
+
+// FNV-1a calcolato su parole di 64 bit; l'ultima parola incompleta viene completata con zeri,
+// come avviene per il riempimento che allinea ogni blocco del file a 8 byte
+static uint64_t checksum(uint64_t sum, const void *data, uint64_t length){
+
+    const unsigned char *bytes = data;
+    uint64_t word, i;
+
+    for (i = 0; i < length; i += 8){
+
+        word = 0;
+
+        memcpy(&word, bytes + i, length - i < 8 ? length - i : 8);
+
+        sum = (sum ^ word) * 0x100000001b3ULL;
+
+    }
+
+    return sum;
+
+}
+
+// Scrive un blocco seguito dagli zeri necessari ad allinearlo a 8 byte e ne aggiorna il checksum
+static int writeBlock(FILE *file, const void *data, uint64_t length, uint64_t *sum){
+
+    static const char padding[8] = { 0 };
+
+    *sum = checksum(*sum, data, length);
+
+    return fwrite(data, 1, length, file) == length && fwrite(padding, 1, ALIGN8(length) - length, file) == ALIGN8(length) - length;
+
+}
+
+int saveHashTable(struct hasht *hashtable, const char *path, unsigned int (*keybytes)(void*, const void**), unsigned int (*objectbytes)(void*, const void**)){
+
+    /*
+        Richiede: struttura hashtable non nulla, percorso del file, funzioni keybytes e objectbytes non nulle
+                    che restituiscono la lunghezza della rappresentazione binaria di una chiave (o di un oggetto)
+                    e ne scrivono l'indirizzo nel secondo parametro
+        Effetto: scrive su file il contenuto della tabella in un formato compatto, versionato e privo di
+                    puntatori, che mapHashTable può aprire senza ricostruire la tabella.
+                    Restituisce True se il file è stato scritto correttamente.
+    */
+
+    struct item { void *key, *object; uint32_t hash; } *items;
+    struct snapshot header;
+    struct entry *entries;
+    struct node *node;
+    struct table *table;
+    uint32_t *offsets, *cursor, *order;
+    uint64_t count, heap, i;
+    unsigned int buckets, b;
+    const void *bytes;
+    FILE *file;
+    int t, ok;
+
+    assert(hashtable != NULL && path != NULL && keybytes != NULL && objectbytes != NULL);
+    assert(hashtable->mode != HASHTABLE_MAPPED);
+
+    count = hashtable->ht[0].used + (isRehashing(hashtable) ? hashtable->ht[1].used : 0);
+
+    for (buckets = 1; buckets < count; buckets <<= 1);
+
+    // Raccoglie gli elementi di entrambe le tabelle insieme al relativo hash
+    items = smalloc((count > 0 ? count : 1) * sizeof(struct item));
+
+    for (i = 0, t = 0; t <= (isRehashing(hashtable) ? 1 : 0); t++){
+
+        table = &(hashtable->ht[t]);
+
+        for (b = 0; b < table->size; b++){
+
+            if (hashtable->mode == HASHTABLE_OPEN){
+
+                if (table->ctrl[b] >= 0)
+
+                    items[i++] = (struct item) { table->slots[b].key, table->slots[b].object, mix(hashtable->hash(table->slots[b].key)) };
+
+            }
+
+            else for (node = table->array[b]; node != NULL; node = node->next)
+
+                items[i++] = (struct item) { node->key, node->object, node->hash };
+
+        }
+
+    }
+
+    // Ordina gli elementi per bucket (counting sort): offsets[b] diventa la posizione del primo elemento del bucket b
+    offsets = smalloc((buckets + 1) * sizeof(uint32_t));
+    cursor = smalloc(buckets * sizeof(uint32_t));
+    order = smalloc((count > 0 ? count : 1) * sizeof(uint32_t));
+    entries = smalloc((count > 0 ? count : 1) * sizeof(struct entry));
+
+    memset(offsets, 0, (buckets + 1) * sizeof(uint32_t));
+
+    for (i = 0; i < count; i++) offsets[(items[i].hash & (buckets - 1)) + 1]++;
+
+    for (b = 0; b < buckets; b++) offsets[b + 1] += offsets[b];
+
+    for (b = 0; b < buckets; b++) cursor[b] = offsets[b];
+
+    for (i = 0; i < count; i++) order[cursor[items[i].hash & (buckets - 1)]++] = i;
+
+    // Assegna le posizioni nello heap seguendo l'ordine degli elementi nel file
+    for (heap = 0, i = 0; i < count; i++){
+
+        entries[i] = (struct entry) {
+            .hash=items[order[i]].hash, .reserved=0,
+            .keylength=keybytes(items[order[i]].key, &bytes),
+            .objectlength=objectbytes(items[order[i]].object, &bytes)
+        };
+
+        entries[i].key = heap;
+        entries[i].object = (heap += ALIGN8(entries[i].keylength));
+
+        heap += ALIGN8(entries[i].objectlength);
+
+    }
+
+    memset(&header, 0, sizeof(struct snapshot));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+
+    header.version = SNAPSHOT_VERSION;
+    header.buckets = buckets;
+    header.count = count;
+    header.length = sizeof(struct snapshot) + ALIGN8((buckets + 1) * sizeof(uint32_t)) + count * sizeof(struct entry) + heap;
+    header.checksum = CHECKSUM_SEED;
+
+    if ((ok = (file = fopen(path, "wb")) != NULL)){
+
+        ok = fwrite(&header, sizeof(struct snapshot), 1, file) == 1
+                && writeBlock(file, offsets, (buckets + 1) * sizeof(uint32_t), &(header.checksum))
+                && writeBlock(file, entries, count * sizeof(struct entry), &(header.checksum));
+
+        for (i = 0; ok && i < count; i++){
+
+            ok = writeBlock(file, bytes, keybytes(items[order[i]].key, &bytes), &(header.checksum))
+                    && writeBlock(file, bytes, objectbytes(items[order[i]].object, &bytes), &(header.checksum));
+
+        }
+
+        // Riscrive l'intestazione con il checksum definitivo
+        ok = ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(struct snapshot), 1, file) == 1;
+        ok = fclose(file) == 0 && ok;
+
+    }
+
+    free(items);
+    free(offsets);
+    free(cursor);
+    free(order);
+    free(entries);
+
+    return ok ? TRUE : FALSE;
+
+}
+
+// Controlla che gli indici del file mappato non escano dal file: offsets crescenti e non oltre count,
+// chiave e oggetto di ogni elemento interamente contenuti nello heap. Richiede tempo O(buckets + count)
+static int validExtents(const struct snapshot *header, uint64_t sections){
+
+    const uint32_t *offsets = (const uint32_t*) (header + 1);
+    const struct entry *entries = (const struct entry*) ((const char*) offsets + ALIGN8(((uint64_t) header->buckets + 1) * sizeof(uint32_t)));
+    uint64_t heap = header->length - sections, i;
+
+    if (offsets[0] != 0) return FALSE;
+
+    for (i = 0; i < header->buckets; i++) if (offsets[i] > offsets[i + 1]) return FALSE;
+
+    for (i = 0; i < header->count; i++){
+
+        if (entries[i].key > heap || entries[i].keylength > heap - entries[i].key) return FALSE;
+
+        if (entries[i].object > heap || entries[i].objectlength > heap - entries[i].object) return FALSE;
+
+    }
+
+    return TRUE;
+
+}
+
+struct hasht* mapHashTable(const char *path, unsigned int (*hashcode)(void*), unsigned int (*keybytes)(void*, const void**), int verify){
+
+    /*
+        Richiede: percorso di un file prodotto da saveHashTable, la stessa funzione hash e la stessa
+                    funzione keybytes usate per creare e salvare la tabella
+        Effetto: mappa il file in memoria in sola lettura e restituisce una tabella HASHTABLE_MAPPED,
+                    su cui searchKey, getObject e le relative versioni batch operano direttamente sul file;
+                    getObject restituisce il puntatore ai byte dell'oggetto all'interno della mappatura.
+                    Le pagine del file sono condivise tra tutti i processi che lo mappano.
+                    Se verify è vero controlla anche il checksum (richiede la lettura dell'intero file).
+                    Restituisce NULL se il file non esiste o non è valido.
+    */
+
+    const struct snapshot *header;
+    struct hasht *hashtable;
+    struct stat info;
+    uint64_t sections;
+    void *map;
+    int fd, valid;
+
+    assert(path != NULL && hashcode != NULL && keybytes != NULL);
+
+    if ((fd = open(path, O_RDONLY)) < 0) return NULL;
+
+    if (fstat(fd, &info) != 0 || (uint64_t) info.st_size < sizeof(struct snapshot)
+            || (map = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED){
+
+        close(fd);
+
+        return NULL;
+
+    }
+
+    // La mappatura rimane valida anche dopo la chiusura del descrittore
+    close(fd);
+
+    header = map;
+    sections = sizeof(struct snapshot) + ALIGN8(((uint64_t) header->buckets + 1) * sizeof(uint32_t)) + header->count * sizeof(struct entry);
+
+    // Le sezioni vengono controllate prima di essere lette; anche senza verify un file troncato o
+    // con indici fuori dai limiti viene rifiutato, così che le ricerche non possano uscire dalla mappatura
+    valid = memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0
+            && header->version == SNAPSHOT_VERSION
+            && header->length == (uint64_t) info.st_size
+            && header->buckets != 0 && (header->buckets & (header->buckets - 1)) == 0
+            && header->count <= header->length / sizeof(struct entry)
+            && sections <= header->length
+            && ((const uint32_t*) (header + 1))[header->buckets] == header->count
+            && validExtents(header, sections)
+            && (!verify || checksum(CHECKSUM_SEED, header + 1, header->length - sizeof(struct snapshot)) == header->checksum);
+
+    if (!valid){
+
+        munmap(map, info.st_size);
+
+        return NULL;
+
+    }
+
+    hashtable = smalloc(sizeof(struct hasht));
+    memset(hashtable, 0, sizeof(struct hasht));
+
+    hashtable->mode = HASHTABLE_MAPPED;
+    hashtable->hash = hashcode;
+    hashtable->keybytes = keybytes;
+    hashtable->rehashidx = -1;
+    hashtable->ht[0].size = header->buckets;
+    hashtable->ht[0].used = header->count;
+
+    hashtable->map = map;
+    hashtable->maplength = info.st_size;
+    hashtable->offsets = (const uint32_t*) (header + 1);
+    hashtable->entries = (const struct entry*) ((const char*) map + sizeof(struct snapshot) + ALIGN8(((uint64_t) header->buckets + 1) * sizeof(uint32_t)));
+    hashtable->heap = (const char*) map + sections;
+
+    return hashtable;
 
 }